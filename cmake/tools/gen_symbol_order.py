@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+"""
+Symbol Ordering File Generator
+Turns profile data into a symbol ordering file for lld (--symbol-ordering-file), so
+the hot functions are packed together at the start of .text and share flash
+accelerator / XIP cache lines instead of being spread over the whole image.
+
+Profile sources, any combination, weights add up:
+  --pc-samples DUMP      PcSampler table dump (see pc_sample_profile.py)
+  --folded FILE          folded stacks "caller;callee count", e.g. from
+                         pc_sample_profile.py --folded or a host-side trace; every frame
+                         of a stack gets the count
+  --isr-profile LOG      printProfiles() output ("isr[ 15]  calls: 1234"), the ISR
+                         functions are named via --map like in isr_trace_to_chrome.py
+  --counts FILE          "count name" lines, name mangled or demangled
+
+The ELF is needed to translate addresses and demangled names into the linkage names
+lld expects. Pass the result to target_configure_kvasir(... SYMBOL_ORDERING_FILE
+<file>).
+"""
+
+import argparse
+import bisect
+import re
+import shutil
+import subprocess
+import sys
+from typing import Dict, List, Optional, Tuple
+
+from isr_trace_to_chrome import isr_names_from_map
+from pc_sample_profile import demangle, read_samples
+
+NM_TOOLS = ("llvm-nm", "arm-none-eabi-nm", "nm")
+
+
+class Functions:
+    """Function symbols of the ELF with linkage and demangled names."""
+
+    def __init__(self, symbols: List[Tuple[int, int, str]]) -> None:
+        symbols.sort()
+        self.starts = [s[0] for s in symbols]
+        self.symbols = symbols
+        demangled = demangle([s[2] for s in symbols])
+        self.by_name: Dict[str, str] = {}
+        for (_, _, mangled), name in zip(symbols, demangled):
+            self.by_name.setdefault(mangled, mangled)
+            self.by_name.setdefault(name, mangled)
+            # names from map files and logs usually lack the parameter list
+            self.by_name.setdefault(re.sub(r'\(.*\)( const)?$', '', name), mangled)
+
+    def at(self, address: int) -> Optional[str]:
+        i = bisect.bisect_right(self.starts, address) - 1
+        if i < 0:
+            return None
+        start, size, name = self.symbols[i]
+        if size != 0 and address >= start + size:
+            return None
+        return name
+
+    def named(self, name: str) -> Optional[str]:
+        return self.by_name.get(name.strip())
+
+
+def functions_from_elf(elf_file: str, nm: Optional[str]) -> Functions:
+    for tool in ([nm] if nm else NM_TOOLS):
+        if not shutil.which(tool):
+            continue
+        out = subprocess.run([tool, "-n", "-S", "--defined-only", elf_file],
+                             capture_output=True, text=True, check=True).stdout
+        symbols = []
+        for line in out.splitlines():
+            match = re.match(r'^([0-9a-fA-F]+)\s+(?:([0-9a-fA-F]+)\s+)?([tTwW])\s+(\S+)$', line)
+            if match:
+                size = int(match.group(2), 16) if match.group(2) else 0
+                symbols.append((int(match.group(1), 16) & ~1, size, match.group(4)))
+        return Functions(symbols)
+    raise RuntimeError("no nm tool found (tried " + ", ".join([nm] if nm else NM_TOOLS) + ")")
+
+
+class Weights:
+    def __init__(self) -> None:
+        self.weights: Dict[str, int] = {}
+        self.unresolved: Dict[str, int] = {}
+
+    def add(self, symbol: Optional[str], weight: int, source: str) -> None:
+        if symbol is None:
+            self.unresolved[source] = self.unresolved.get(source, 0) + weight
+        else:
+            self.weights[symbol] = self.weights.get(symbol, 0) + weight
+
+
+def add_pc_samples(w: Weights, functions: Functions, dump: str) -> None:
+    samples, _, _ = read_samples(dump)
+    for s in samples:
+        w.add(functions.at(s.pc), s.count, f"0x{s.pc:08x}")
+
+
+def add_folded(w: Weights, functions: Functions, folded: str) -> None:
+    with open(folded, "r") as f:
+        for line in f:
+            stack, _, count = line.rstrip().rpartition(" ")
+            if not stack or not count.isdigit():
+                continue
+            for frame in set(stack.split(";")):
+                symbol = functions.named(frame)
+                if symbol is None and frame.startswith("0x"):
+                    symbol = functions.at(int(frame, 16))
+                w.add(symbol, int(count), frame)
+
+
+def add_isr_profile(w: Weights, functions: Functions, log: str, map_file: str) -> None:
+    names = isr_names_from_map(map_file)
+    with open(log, "r", errors="replace") as f:
+        for match in re.finditer(r'isr\[\s*(-?\d+)\]\s+calls:\s*(\d+)', f.read()):
+            index = int(match.group(1))
+            name = names.get(index, f"isr[{index}]")
+            w.add(functions.named(name), int(match.group(2)), name)
+
+
+def add_counts(w: Weights, functions: Functions, counts: str) -> None:
+    with open(counts, "r") as f:
+        for line in f:
+            match = re.match(r'^\s*(\d+)\s+(?:[\d.]+%\s+)?(.+)$', line)
+            if match:
+                w.add(functions.named(match.group(2)), int(match.group(1)), match.group(2).strip())
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(
+        description="Generate an lld symbol ordering file from Kvasir profile data")
+    parser.add_argument("elf", help="firmware ELF the profile was taken with")
+    parser.add_argument("output", help="symbol ordering file to write")
+    parser.add_argument("--pc-samples", action="append", default=[], metavar="DUMP")
+    parser.add_argument("--folded", action="append", default=[], metavar="FILE")
+    parser.add_argument("--isr-profile", action="append", default=[], metavar="LOG")
+    parser.add_argument("--map", help="linker map file, needed for --isr-profile")
+    parser.add_argument("--counts", action="append", default=[], metavar="FILE")
+    parser.add_argument("--nm", help="nm tool (default: first of " + ", ".join(NM_TOOLS) + ")")
+    parser.add_argument("--max-symbols", type=int, default=0,
+                        help="only order the N hottest functions (default: all with samples)")
+    args = parser.parse_args()
+
+    if args.isr_profile and not args.map:
+        parser.error("--isr-profile needs --map")
+
+    try:
+        functions = functions_from_elf(args.elf, args.nm)
+        w = Weights()
+        for dump in args.pc_samples:
+            add_pc_samples(w, functions, dump)
+        for folded in args.folded:
+            add_folded(w, functions, folded)
+        for log in args.isr_profile:
+            add_isr_profile(w, functions, log, args.map)
+        for counts in args.counts:
+            add_counts(w, functions, counts)
+    except (OSError, ValueError, RuntimeError, subprocess.CalledProcessError) as e:
+        print(f"Error: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    ordered = sorted(w.weights.items(), key=lambda kv: (-kv[1], kv[0]))
+    if args.max_symbols:
+        ordered = ordered[:args.max_symbols]
+
+    with open(args.output, "w") as f:
+        for symbol, _ in ordered:
+            f.write(symbol + "\n")
+
+    print(f"{len(ordered)} hot functions -> {args.output}")
+    if w.unresolved:
+        worst = sorted(w.unresolved.items(), key=lambda kv: -kv[1])[:5]
+        print(f"Warning: {len(w.unresolved)} profile entries not found in the ELF, e.g. "
+              + ", ".join(name for name, _ in worst), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""
+ISR Trace Converter
+Converts a dump of Kvasir::Startup::isrTraceBuffer (see src/kvasir/StartUp/IsrTrace.hpp)
+into the Chrome trace event JSON format, viewable in chrome://tracing or ui.perfetto.dev.
+
+The dump is the raw memory of the buffer, e.g. taken with J-Link after stopping the trace:
+    savebin trace.bin <address of isrTraceBuffer> <size of isrTraceBuffer>
+The map file is used to name the ISR indices after the functions wrapped by
+IsrProfileWrapper.
+"""
+
+import argparse
+import json
+import re
+import shutil
+import struct
+import subprocess
+import sys
+from typing import Dict, List, Optional
+
+HEADER = struct.Struct("<II")        # writeIndex, stopped
+RECORD = struct.Struct("<IIhH")      # enter, exit, id, kind
+
+KIND_EMPTY = 0
+KIND_ISR = 1
+KIND_MARKER = 2
+
+WRAPPER_PATTERN = re.compile(
+    r'IsrProfileWrapper<&?(?P<fn>[^,<>]+(?:<[^<>]*>)?[^,<>]*),\s*Kvasir::Nvic::Index<(?P<idx>-?\d+)>')
+
+
+class TraceRecord:
+    """One record of the trace buffer with timestamps extended to 64 bit."""
+
+    def __init__(self, enter: int, exit: int, id: int, kind: int) -> None:
+        self.enter = enter
+        self.exit = exit
+        self.id = id
+        self.kind = kind
+
+
+def demangle(text: str) -> str:
+    """Demangle all Itanium symbols in text if a demangler is available."""
+    if "_Z" not in text:
+        return text
+    for tool in ("llvm-cxxfilt", "c++filt", "arm-none-eabi-c++filt"):
+        if shutil.which(tool):
+            try:
+                return subprocess.run([tool], input=text, capture_output=True,
+                                      text=True, check=True).stdout
+            except (subprocess.CalledProcessError, OSError):
+                continue
+    print("Warning: no demangler found, ISR names may be missing", file=sys.stderr)
+    return text
+
+
+def isr_names_from_map(map_file: str) -> Dict[int, str]:
+    """Map ISR index -> name of the original ISR function wrapped by IsrProfileWrapper."""
+    with open(map_file, "r", errors="replace") as f:
+        content = demangle(f.read())
+
+    names: Dict[int, str] = {}
+    for match in WRAPPER_PATTERN.finditer(content):
+        fn = match.group("fn").strip()
+        fn = re.sub(r'\(\)$', '', fn)
+        names.setdefault(int(match.group("idx")), fn)
+    return names
+
+
+def read_records(dump_file: str) -> List[TraceRecord]:
+    """Read the ring buffer and return the records oldest first."""
+    with open(dump_file, "rb") as f:
+        data = f.read()
+
+    if len(data) < HEADER.size + RECORD.size:
+        raise ValueError(f"dump '{dump_file}' is too small for a trace buffer")
+
+    write_index, _ = HEADER.unpack_from(data, 0)
+    capacity = (len(data) - HEADER.size) // RECORD.size
+    if capacity & (capacity - 1):
+        print(f"Warning: capacity {capacity} is not a power of two, "
+              "is the dump the complete buffer?", file=sys.stderr)
+
+    raw = [RECORD.unpack_from(data, HEADER.size + i * RECORD.size)
+           for i in range(capacity)]
+
+    if write_index <= capacity:
+        ordered = raw[:write_index]
+    else:
+        oldest = write_index % capacity
+        ordered = raw[oldest:] + raw[:oldest]
+
+    # records are written on ISR exit, so exit timestamps are (almost) monotonic;
+    # use them to extend the 32 bit timestamps across counter wraps
+    records: List[TraceRecord] = []
+    base = 0
+    last_exit: Optional[int] = None
+    for enter, exit, id, kind in ordered:
+        if kind == KIND_EMPTY:
+            continue
+        if last_exit is not None and exit < last_exit and last_exit - exit > 0x80000000:
+            base += 1 << 32
+        last_exit = exit
+        exit64 = base + exit
+        enter64 = exit64 - ((exit - enter) & 0xFFFFFFFF)
+        records.append(TraceRecord(enter64, exit64, id, kind))
+    return records
+
+
+def to_chrome_trace(records: List[TraceRecord], names: Dict[int, str],
+                    markers: Dict[int, str], cycles_per_us: float) -> dict:
+    """Build the Chrome trace event JSON object."""
+    events = []
+    start = min((r.enter for r in records), default=0)
+
+    def ts(cycles: int) -> float:
+        return (cycles - start) / cycles_per_us
+
+    for r in records:
+        if r.kind == KIND_ISR:
+            name = names.get(r.id, f"isr[{r.id}]")
+            events.append({"name": name, "cat": "isr", "ph": "X", "pid": 0, "tid": 0,
+                           "ts": ts(r.enter), "dur": (r.exit - r.enter) / cycles_per_us,
+                           "args": {"index": r.id, "cycles": r.exit - r.enter}})
+        elif r.kind == KIND_MARKER:
+            events.append({"name": markers.get(r.id, f"marker {r.id}"), "cat": "marker",
+                           "ph": "i", "s": "g", "pid": 0, "tid": 0, "ts": ts(r.enter)})
+        else:
+            print(f"Warning: skipping record with unknown kind {r.kind}", file=sys.stderr)
+
+    return {"traceEvents": events, "displayTimeUnit": "ns",
+            "otherData": {"records": len(records)}}
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(
+        description="Convert a Kvasir ISR trace dump into Chrome trace JSON")
+    parser.add_argument("dump", help="raw dump of Kvasir::Startup::isrTraceBuffer")
+    parser.add_argument("map", help="linker map file of the firmware")
+    parser.add_argument("output", help="output JSON file")
+    parser.add_argument("--cpu-hz", type=float, default=1e6,
+                        help="TimeSource frequency in Hz (default: 1e6, timestamps in cycles)")
+    parser.add_argument("--marker", action="append", default=[], metavar="ID=NAME",
+                        help="name for a KVASIR_TRACE_EVENT id, may be repeated")
+    args = parser.parse_args()
+
+    markers: Dict[int, str] = {}
+    for m in args.marker:
+        id, sep, name = m.partition("=")
+        if not sep:
+            print(f"Invalid --marker '{m}', expected ID=NAME", file=sys.stderr)
+            sys.exit(1)
+        markers[int(id, 0)] = name
+
+    try:
+        records = read_records(args.dump)
+    except (OSError, ValueError) as e:
+        print(f"Error reading trace dump: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    names = isr_names_from_map(args.map)
+    trace = to_chrome_trace(records, names, markers, args.cpu_hz / 1e6)
+
+    with open(args.output, "w") as f:
+        json.dump(trace, f)
+
+    print(f"{len(records)} records, {len(names)} named ISRs -> {args.output}")
+
+
+if __name__ == "__main__":
+    main()
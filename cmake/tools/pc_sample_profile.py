@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+"""
+PC Sample Profiler
+Symbolizes a dump of Kvasir::Startup::PcSampler<...>::table (see
+src/kvasir/StartUp/PcSampler.hpp) into a flat profile and a folded-stack file for
+flamegraph.pl / speedscope / inferno.
+
+The dump is the raw memory of the table, e.g. taken with J-Link after stop():
+    savebin samples.bin <address of table> <size of table>
+Symbols come from the ELF (via nm) or from the linker map file.
+
+Each sample is a (pc, lr) pair. The LR is the caller only if the sampled function is a
+leaf or has not saved LR yet, so the folded stacks are at most two frames deep and the
+caller frame is a hint, not a proof.
+"""
+
+import argparse
+import bisect
+import re
+import shutil
+import struct
+import subprocess
+import sys
+from typing import Dict, List, Optional, Tuple
+
+from beautify_lst import extract_meaningful_name
+
+HEADER = struct.Struct("<III")       # samples, dropped, stopped
+BUCKET = struct.Struct("<III")       # pc, lr, count
+
+NM_TOOLS = ("llvm-nm", "arm-none-eabi-nm", "nm")
+
+
+class Sample:
+    """One bucket of the sample table."""
+
+    def __init__(self, pc: int, lr: int, count: int) -> None:
+        self.pc = pc
+        self.lr = lr
+        self.count = count
+
+
+class SymbolTable:
+    """Address sorted function symbols for address -> name lookups."""
+
+    def __init__(self, symbols: List[Tuple[int, int, str]]) -> None:
+        symbols.sort()
+        self.starts = [s[0] for s in symbols]
+        self.symbols = symbols
+
+    def lookup(self, address: int) -> Optional[str]:
+        i = bisect.bisect_right(self.starts, address) - 1
+        if i < 0:
+            return None
+        start, size, name = self.symbols[i]
+        if size != 0 and address >= start + size:
+            return None
+        return name
+
+    def __len__(self) -> int:
+        return len(self.symbols)
+
+
+def read_samples(dump_file: str) -> Tuple[List[Sample], int, int]:
+    """Read the table dump, returns (used buckets, total samples, dropped samples)."""
+    with open(dump_file, "rb") as f:
+        data = f.read()
+
+    if len(data) < HEADER.size + BUCKET.size:
+        raise ValueError(f"dump '{dump_file}' is too small for a sample table")
+
+    samples, dropped, _ = HEADER.unpack_from(data, 0)
+    bucket_count = (len(data) - HEADER.size) // BUCKET.size
+    if bucket_count & (bucket_count - 1):
+        print(f"Warning: {bucket_count} buckets is not a power of two, "
+              "is the dump the complete table?", file=sys.stderr)
+
+    buckets = []
+    for i in range(bucket_count):
+        pc, lr, count = BUCKET.unpack_from(data, HEADER.size + i * BUCKET.size)
+        if pc != 0 and count != 0:
+            buckets.append(Sample(pc, lr, count))
+    return buckets, samples, dropped
+
+
+def symbols_from_elf(elf_file: str) -> List[Tuple[int, int, str]]:
+    """Function symbols of an ELF file via nm, thumb bit removed."""
+    for tool in NM_TOOLS:
+        if not shutil.which(tool):
+            continue
+        try:
+            out = subprocess.run([tool, "-n", "-S", "-C", "--defined-only", elf_file],
+                                 capture_output=True, text=True, check=True).stdout
+        except (subprocess.CalledProcessError, OSError):
+            continue
+        symbols = []
+        for line in out.splitlines():
+            # address [size] type name
+            match = re.match(r'^([0-9a-fA-F]+)\s+(?:([0-9a-fA-F]+)\s+)?([tTwW])\s+(.+)$', line)
+            if match:
+                address = int(match.group(1), 16) & ~1
+                size = int(match.group(2), 16) if match.group(2) else 0
+                symbols.append((address, size, match.group(4)))
+        return symbols
+    raise RuntimeError("no nm tool found (tried " + ", ".join(NM_TOOLS) + ")")
+
+
+def demangle(names: List[str]) -> List[str]:
+    """Demangle a list of symbols if a demangler is available."""
+    if not any(n.startswith("_Z") for n in names):
+        return names
+    for tool in ("llvm-cxxfilt", "c++filt", "arm-none-eabi-c++filt"):
+        if shutil.which(tool):
+            try:
+                out = subprocess.run([tool], input="\n".join(names), capture_output=True,
+                                     text=True, check=True).stdout
+                return out.splitlines()
+            except (subprocess.CalledProcessError, OSError):
+                continue
+    return names
+
+
+def symbols_from_map(map_file: str) -> List[Tuple[int, int, str]]:
+    """Symbols of a linker map file, lld ("VMA LMA Size Align Out In Symbol") or GNU ld."""
+    with open(map_file, "r", errors="replace") as f:
+        lines = f.readlines()
+
+    symbols = []
+    lld_symbol = re.compile(r'^\s*([0-9a-fA-F]+)\s+[0-9a-fA-F]+\s+([0-9a-fA-F]+)\s+\d+\s{9,}(\S.*)$')
+    gnu_section = re.compile(r'^\s*\.text\.(\S+)\s*(?:0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+))?')
+    gnu_values = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+\S')
+    pending: Optional[str] = None
+    for line in lines:
+        match = lld_symbol.match(line)
+        if match and not match.group(3).startswith((".", "<")) and ".o:(" not in match.group(3):
+            symbols.append((int(match.group(1), 16) & ~1, 0, match.group(3).strip()))
+            continue
+        match = gnu_section.match(line)
+        if match:
+            if match.group(2):
+                symbols.append((int(match.group(2), 16), int(match.group(3), 16), match.group(1)))
+                pending = None
+            else:
+                pending = match.group(1)   # values follow on the next line
+            continue
+        if pending:
+            match = gnu_values.match(line)
+            if match:
+                symbols.append((int(match.group(1), 16), int(match.group(2), 16), pending))
+            pending = None
+
+    names = demangle([s[2] for s in symbols])
+    return [(a, s, n) for (a, s, _), n in zip(symbols, names)]
+
+
+def load_symbols(symbol_file: str) -> SymbolTable:
+    if symbol_file.endswith(".map"):
+        return SymbolTable(symbols_from_map(symbol_file))
+    return SymbolTable(symbols_from_elf(symbol_file))
+
+
+def frame_name(symbols: SymbolTable, address: int, short: bool) -> str:
+    name = symbols.lookup(address)
+    if name is None:
+        return f"0x{address:08x}"
+    name = extract_meaningful_name(name) if short else name
+    return name.replace(";", ":")   # ';' separates frames in folded stacks
+
+
+def flat_profile(samples: List[Sample], symbols: SymbolTable, short: bool) -> Dict[str, int]:
+    flat: Dict[str, int] = {}
+    for s in samples:
+        name = frame_name(symbols, s.pc, short)
+        flat[name] = flat.get(name, 0) + s.count
+    return flat
+
+
+def folded_stacks(samples: List[Sample], symbols: SymbolTable, short: bool) -> Dict[str, int]:
+    folded: Dict[str, int] = {}
+    for s in samples:
+        leaf = frame_name(symbols, s.pc, short)
+        # LR points behind the call instruction
+        caller = frame_name(symbols, s.lr - 2, short) if s.lr else None
+        stack = leaf if caller is None or caller == leaf else f"{caller};{leaf}"
+        folded[stack] = folded.get(stack, 0) + s.count
+    return folded
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(
+        description="Symbolize a Kvasir PcSampler table dump into a flat profile and folded stacks")
+    parser.add_argument("dump", help="raw dump of PcSampler<...>::table")
+    parser.add_argument("symbols", help="firmware ELF (symbolized with nm) or linker map file (.map)")
+    parser.add_argument("--flat", metavar="FILE", help="write the flat profile to FILE instead of stdout")
+    parser.add_argument("--folded", metavar="FILE", help="write folded stacks (flamegraph.pl format) to FILE")
+    parser.add_argument("--short", action="store_true", help="shorten long template names")
+    parser.add_argument("--top", type=int, default=0, help="only list the N hottest functions")
+    args = parser.parse_args()
+
+    try:
+        samples, total, dropped = read_samples(args.dump)
+        symbols = load_symbols(args.symbols)
+    except (OSError, ValueError, RuntimeError) as e:
+        print(f"Error: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    counted = sum(s.count for s in samples)
+    flat = sorted(flat_profile(samples, symbols, args.short).items(), key=lambda kv: -kv[1])
+    if args.top:
+        flat = flat[:args.top]
+
+    lines = [f"{total} samples, {dropped} dropped, {len(symbols)} symbols", "",
+             f"{'samples':>10} {'%':>7}  function"]
+    for name, count in flat:
+        lines.append(f"{count:>10} {100.0 * count / max(counted, 1):>6.2f}%  {name}")
+    report = "\n".join(lines) + "\n"
+
+    if args.flat:
+        with open(args.flat, "w") as f:
+            f.write(report)
+    else:
+        sys.stdout.write(report)
+
+    if args.folded:
+        with open(args.folded, "w") as f:
+            for stack, count in sorted(folded_stacks(samples, symbols, args.short).items()):
+                f.write(f"{stack} {count}\n")
+
+    if dropped:
+        print(f"Warning: {dropped} samples dropped, the table is too small", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -2,12 +2,25 @@
 """
 Memory Usage Analysis Tool for Embedded Systems
 Analyzes binary files and generates formatted memory usage reports
+
+Usage is reported per MEMORY region of the linker script, so the optional RAM banks
+(fast_ram, dma_ram, cold_ram) show up as their own, labeled rows. Flash usage
+includes the load images of .data, .fastData and .coldData.
+
+With --nm the sizes are also attributed to symbols (via nm), to template families
+(the demangled name without template and function arguments, so all
+Kvasir::Register::apply<...> instantiations add up) and to namespaces. --json writes
+everything to a file, --diff compares against such a file of a previous build and
+lists what grew or shrank.
 """
 
+import argparse
+import json
 import subprocess
 import sys
 import re
-from typing import List, Union, Dict
+import struct
+from typing import List, Tuple, Union, Dict
 from linker_utils import get_memory_regions, find_region_for_address, parse_size as parse_size_util
 
 
@@ -39,6 +52,29 @@ class Section:
         self.addr = addr
 
 
+# optional RAM banks of linker/common_{fast,dma,cold}_ram.ld, labeled in the report
+BANK_LABELS = {"fast_ram": "hot", "dma_ram": "DMA", "cold_ram": "cold"}
+
+
+def load_images(binary: str) -> List[Tuple[int, int]]:
+    """(load address, size) of every loadable segment stored away from where it runs,
+    i.e. the flash copies of .data, .fastData and .coldData, from the ELF32 program
+    headers."""
+    with open(binary, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF" or elf[4] != 1:
+        return []
+    endian = "<" if elf[5] == 1 else ">"
+    phoff, = struct.unpack_from(endian + "I", elf, 28)
+    phentsize, phnum = struct.unpack_from(endian + "HH", elf, 42)
+    images: List[Tuple[int, int]] = []
+    for i in range(phnum):
+        p_type, _, vaddr, paddr, filesz = struct.unpack_from(endian + "5I", elf, phoff + i * phentsize)
+        if p_type == 1 and filesz != 0 and vaddr != paddr:   # PT_LOAD
+            images.append((paddr, filesz))
+    return images
+
+
 def humanbytes(B: Union[int, float]) -> str:
     """Convert bytes to human-readable format."""
     B = float(B)
@@ -57,22 +93,82 @@ def machinebytes(size_string: str) -> int:
     return parse_size_util(size_string)
 
 
-def main() -> None:
-    """Main function to analyze memory usage and generate report."""
-    if len(sys.argv) != 7:
-        print("Usage: pretty_size.py <size_tool> <binary> <flash_size> <ram_size> <eeprom_size> <linker_file>", file=sys.stderr)
-        sys.exit(1)
-
-    size_tool = sys.argv[1]
-    binary = sys.argv[2]
-    linker_file = sys.argv[6]
-
-    # Parse memory regions from linker script
-    memory_regions = get_memory_regions(linker_file)
-    if not memory_regions:
-        print(
-            f"Warning: Could not parse memory regions from linker file '{linker_file}'", file=sys.stderr)
+class SymbolUsage:
+    """Size of one demangled symbol, summed over all copies with that name."""
 
+    def __init__(self, name: str, region: str) -> None:
+        self.name = name
+        self.region = region
+        self.size = 0
+
+
+def strip_enclosed(text: str, open_char: str, close_char: str) -> str:
+    """Remove all (nested) open_char ... close_char groups."""
+    out = []
+    depth = 0
+    for c in text:
+        if c == open_char:
+            depth += 1
+        elif c == close_char and depth > 0:
+            depth -= 1
+        elif depth == 0:
+            out.append(c)
+    return "".join(out)
+
+
+def template_family(name: str) -> str:
+    """Demangled name without function parameters and template arguments."""
+    # operator<, operator<< and friends would confuse the bracket matching
+    protected = re.sub(r'operator\s*(<<=|>>=|<=>|<<|>>|<=|>=|<|>|\(\))', 'operator@', name)
+    protected = re.sub(r'operator\s+(new|delete)', r'operator@\1', protected)
+    family = strip_enclosed(strip_enclosed(protected, "(", ")"), "<", ">")
+    family = re.sub(r'\s+const$', '', family).strip()
+    # drop the return type that template functions are demangled with
+    tokens = family.split()
+    if len(tokens) > 1:
+        family = tokens[-1]
+    return re.sub(r'operator@(new|delete)', r'operator \1', family).replace("operator@", "operator")
+
+
+def namespace_of(family: str) -> str:
+    """Namespace (or class) part of a template family, '(global)' if there is none."""
+    parts = family.split("::")
+    return "::".join(parts[:-1]) if len(parts) > 1 else "(global)"
+
+
+def read_symbols(nm_tool: str, binary: str, memory_regions) -> Dict[str, SymbolUsage]:
+    """Demangled symbols with a size, keyed by name, tagged with their memory region."""
+    out = subprocess.run([nm_tool, "-S", "-C", "--defined-only", binary],
+                         capture_output=True, text=True, check=True).stdout
+    symbols: Dict[str, SymbolUsage] = {}
+    for line in out.splitlines():
+        # address size type name
+        match = re.match(r'^([0-9a-fA-F]+)\s+([0-9a-fA-F]+)\s+([a-zA-Z])\s+(.+)$', line)
+        if not match or match.group(3) in "aANn":
+            continue
+        size = int(match.group(2), 16)
+        if size == 0:
+            continue
+        region = find_region_for_address(memory_regions, int(match.group(1), 16))
+        name = match.group(4)
+        if name not in symbols:
+            symbols[name] = SymbolUsage(name, region.name if region else "(none)")
+        symbols[name].size += size
+    return symbols
+
+
+def group_sizes(symbols: Dict[str, SymbolUsage], key) -> Dict[str, Dict[str, int]]:
+    """Sizes per region and group, key maps a symbol name to its group."""
+    groups: Dict[str, Dict[str, int]] = {}
+    for s in symbols.values():
+        region = groups.setdefault(s.region, {})
+        group = key(s.name)
+        region[group] = region.get(group, 0) + s.size
+    return groups
+
+
+def region_usage_of(size_tool: str, binary: str, memory_regions) -> Dict[str, MemoryRegionUsage]:
+    """Used bytes per memory region, summed from the section table of the binary."""
     # Create usage tracking for each memory region
     region_usage: Dict[str, MemoryRegionUsage] = {}
     for region in memory_regions:
@@ -86,10 +182,10 @@ def main() -> None:
         lines = objdump_res.splitlines()
     except subprocess.CalledProcessError as e:
         print(f"Error running size tool '{size_tool}': {e}", file=sys.stderr)
-        sys.exit(1)
+        raise SystemExit(1)
     except FileNotFoundError:
         print(f"Size tool '{size_tool}' not found", file=sys.stderr)
-        sys.exit(1)
+        raise SystemExit(1)
 
     # Remove header and footer lines
     if len(lines) >= 4:
@@ -99,7 +195,7 @@ def main() -> None:
         del lines[0]
     else:
         print("Unexpected output format from size tool", file=sys.stderr)
-        sys.exit(1)
+        raise SystemExit(1)
 
     # Parse sections with addresses
     sections: List[Section] = []
@@ -151,11 +247,29 @@ def main() -> None:
         if region and region.name in region_usage:
             region_usage[region.name].used += size
 
+    # initialized RAM sections also occupy their load image (in flash)
+    try:
+        images = load_images(binary)
+    except (OSError, struct.error) as e:
+        print(f"Warning: load images not counted, cannot read program headers: {e}", file=sys.stderr)
+        images = []
+    for addr, size in images:
+        region = find_region_for_address(memory_regions, addr)
+        if region and region.name in region_usage:
+            region_usage[region.name].used += size
+
+    return region_usage
+
+
+def print_regions(region_usage: Dict[str, MemoryRegionUsage]) -> None:
     # Create print records only for regions that exist
     print_records: List[PrintRecord] = []
     for usage in region_usage.values():
+        name = usage.name
+        if name in BANK_LABELS:
+            name = f"{name} ({BANK_LABELS[name]})"
         print_records.append(PrintRecord(
-            usage.name, usage.used, usage.size, 0))
+            name, usage.used, usage.size, 0))
 
     if not print_records:
         print("No memory regions found", file=sys.stderr)
@@ -190,5 +304,115 @@ def main() -> None:
         print(fmt_string.format(pr.name, pr.used, pr.size, pr.perc))
 
 
+def print_top(title: str, sizes: Dict[str, int], top: int) -> None:
+    print(f"\n{title}")
+    for name, size in sorted(sizes.items(), key=lambda kv: -kv[1])[:top]:
+        print(f"{size:>10}  {name}")
+
+
+def print_breakdown(symbols: Dict[str, SymbolUsage], top: int) -> None:
+    """Largest symbols, template families and namespaces per memory region."""
+    families = group_sizes(symbols, template_family)
+    namespaces = group_sizes(symbols, lambda n: namespace_of(template_family(n)))
+    per_symbol = group_sizes(symbols, lambda n: n)
+    for region in sorted(per_symbol):
+        print_top(f"[{region}] largest namespaces", namespaces[region], top)
+        print_top(f"[{region}] largest template families", families[region], top)
+        print_top(f"[{region}] largest symbols", per_symbol[region], top)
+
+
+def to_json(region_usage: Dict[str, MemoryRegionUsage], symbols: Dict[str, SymbolUsage]) -> dict:
+    return {
+        "regions": {r.name: {"used": r.used, "size": r.size} for r in region_usage.values()},
+        "symbols": {s.name: {"size": s.size, "region": s.region} for s in symbols.values()},
+    }
+
+
+def diff_sizes(old: Dict[str, int], new: Dict[str, int]) -> List[Tuple[str, int, int]]:
+    """(name, old size, new size) of everything that changed, largest change first."""
+    changed = [(n, old.get(n, 0), new.get(n, 0)) for n in set(old) | set(new)
+               if old.get(n, 0) != new.get(n, 0)]
+    return sorted(changed, key=lambda c: (-abs(c[2] - c[1]), c[0]))
+
+
+def print_diff(old: dict, new: dict, top: int) -> None:
+    """Growth per region, template family and symbol against a previous --json file."""
+    print("\nSize diff against previous build")
+    for name, r in new["regions"].items():
+        before = old.get("regions", {}).get(name, {}).get("used", 0)
+        print(f"{name:>14} {r['used'] - before:>+10}  ({before} -> {r['used']})")
+
+    def flat(data: dict, key) -> Dict[str, int]:
+        sizes: Dict[str, int] = {}
+        for name, s in data.get("symbols", {}).items():
+            k = f"[{s['region']}] {key(name)}"
+            sizes[k] = sizes.get(k, 0) + s["size"]
+        return sizes
+
+    for title, key in (("template families", template_family), ("symbols", lambda n: n)):
+        changes = diff_sizes(flat(old, key), flat(new, key))
+        if not changes:
+            continue
+        print(f"\nChanged {title} ({len(changes)})")
+        for name, before, after in changes[:top]:
+            print(f"{after - before:>+10}  {name}  ({before} -> {after})")
+
+
+def main() -> None:
+    """Main function to analyze memory usage and generate report."""
+    parser = argparse.ArgumentParser(description="Memory usage report of a firmware ELF")
+    parser.add_argument("size_tool")
+    parser.add_argument("binary")
+    parser.add_argument("flash_size")
+    parser.add_argument("ram_size")
+    parser.add_argument("eeprom_size")
+    parser.add_argument("linker_file")
+    parser.add_argument("--nm", metavar="TOOL", help="nm tool, enables the per-symbol attribution")
+    parser.add_argument("--breakdown", type=int, metavar="N", default=0,
+                        help="print the N largest namespaces, template families and symbols per region")
+    parser.add_argument("--json", metavar="FILE", help="write region and symbol sizes to FILE")
+    parser.add_argument("--diff", metavar="FILE", help="compare against the --json FILE of a previous build")
+    parser.add_argument("--top", type=int, default=30, help="number of lines per --diff table (default: 30)")
+    args = parser.parse_args()
+
+    if (args.breakdown or args.diff) and not args.nm:
+        parser.error("--breakdown and --diff need --nm")
+
+    # Parse memory regions from linker script
+    memory_regions = get_memory_regions(args.linker_file)
+    if not memory_regions:
+        print(
+            f"Warning: Could not parse memory regions from linker file '{args.linker_file}'", file=sys.stderr)
+
+    region_usage = region_usage_of(args.size_tool, args.binary, memory_regions)
+    print_regions(region_usage)
+
+    if not args.nm:
+        return
+
+    try:
+        symbols = read_symbols(args.nm, args.binary, memory_regions)
+    except (subprocess.CalledProcessError, OSError) as e:
+        print(f"Error running nm tool '{args.nm}': {e}", file=sys.stderr)
+        sys.exit(1)
+
+    if args.breakdown:
+        print_breakdown(symbols, args.breakdown)
+
+    current = to_json(region_usage, symbols)
+    if args.diff:
+        try:
+            with open(args.diff, "r") as f:
+                previous = json.load(f)
+        except (OSError, ValueError) as e:
+            print(f"Warning: no size diff, cannot read '{args.diff}': {e}", file=sys.stderr)
+        else:
+            print_diff(previous, current, args.top)
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(current, f, indent=1, sort_keys=True)
+
+
 if __name__ == "__main__":
     main()
@@ -0,0 +1,278 @@
+#!/usr/bin/env python3
+"""
+Static Stack Analysis
+Computes a worst-case stack bound of a linked Cortex-M firmware from its disassembly.
+
+The per-function stack frame is taken from the stack pointer adjustments in the
+function (push, vpush, stmdb sp!, sub sp); the call graph from direct calls (bl, blx
+<label>) and tail calls (b to another function). The analysis runs on the final
+(LTO'd) ELF, so it sees exactly the code that is executed; -fstack-usage output of an
+LTO build belongs to the temporary link-time objects and misses the inlining.
+
+Roots are read from the .vectors section: the reset handler (thread mode) and every
+distinct ISR. Each ISR adds its own call tree plus the exception frame (32 bytes,
+104 with FPU context). ISRs only nest across priority levels, so with
+--priority-levels N only the N deepest ISRs are stacked on top of the reset path.
+Without it every ISR is assumed to preempt every other one, an upper estimate far
+beyond the real worst case once there are more than a few handlers; the two stage
+link only sizes the stack by a bound with priority levels.
+
+The bound is not reliable for recursion, indirect calls and SP adjustments by a
+register (alloca, Thumb1 frames beyond the immediate range, frame pointer
+restores); these are reported as warnings and counted as if the cycle, call
+target or adjustment did not exist.
+"""
+
+import argparse
+import re
+import subprocess
+import sys
+from typing import Dict, List, Optional, Set, Tuple
+
+EXCEPTION_FRAME = 32
+EXCEPTION_FRAME_FPU = 104
+
+FUNCTION_PATTERN = re.compile(r'^([0-9a-fA-F]+) <(.+)>:\s*$')
+INSTRUCTION_PATTERN = re.compile(r'^\s*([0-9a-fA-F]+):\s+([a-z][\w.]*)\s*(.*)$')
+TARGET_PATTERN = re.compile(r'^(?:0x)?([0-9a-fA-F]+)\b')
+REGISTER_LIST_PATTERN = re.compile(r'\{([^}]*)\}')
+IMMEDIATE_PATTERN = re.compile(r'#(-?(?:0x[0-9a-fA-F]+|\d+))')
+
+# unconditional and conditional branches that may leave the function (tail calls)
+BRANCHES = {"b", "b.w", "b.n"} | {f"b{c}{w}" for c in ("eq", "ne", "cs", "hs", "cc", "lo", "mi", "pl",
+                                                     "vs", "vc", "hi", "ls", "ge", "lt", "gt", "le")
+                                  for w in ("", ".w", ".n")}
+
+
+class Function:
+    """Stack frame and callees of one function."""
+
+    def __init__(self, address: int, name: str) -> None:
+        self.address = address
+        self.name = name
+        self.frame = 0
+        self.calls: Set[int] = set()   # target addresses, resolved in Analysis
+        self.indirect = False
+        self.dynamic = False
+        self.uses_fpu = False
+
+
+def register_count(operands: str) -> Tuple[int, int]:
+    """Number of (core or single precision, double precision) registers in a register list."""
+    match = REGISTER_LIST_PATTERN.search(operands)
+    if not match:
+        return 0, 0
+    words, doubles = 0, 0
+    for part in match.group(1).split(","):
+        part = part.strip()
+        first, _, last = part.partition("-")
+        count = 1
+        if last:
+            count = int(re.sub(r'\D', '', last)) - int(re.sub(r'\D', '', first)) + 1
+        if first.startswith("d"):
+            doubles += count
+        elif first:
+            words += count
+    return words, doubles
+
+
+def immediate(operands: str) -> Optional[int]:
+    match = IMMEDIATE_PATTERN.search(operands)
+    return int(match.group(1), 0) if match else None
+
+
+def parse_disassembly(text: str) -> Dict[str, Function]:
+    """Functions of an objdump/llvm-objdump -d listing, keyed by address."""
+    functions: Dict[int, Function] = {}
+    current: Optional[Function] = None
+    for line in text.splitlines():
+        match = FUNCTION_PATTERN.match(line)
+        if match:
+            current = Function(int(match.group(1), 16), match.group(2))
+            functions[current.address] = current
+            continue
+        match = INSTRUCTION_PATTERN.match(line)
+        if not match or current is None:
+            continue
+        mnemonic = match.group(2)
+        operands = match.group(3).split(";")[0].split("@")[0].strip()
+        analyze_instruction(current, mnemonic, operands)
+    return functions
+
+
+def analyze_instruction(f: Function, mnemonic: str, operands: str) -> None:
+    base = mnemonic.split(".")[0]
+    if base.startswith("v") and base not in ("vpush", "vpop"):
+        f.uses_fpu = True
+
+    if base == "push" or (base in ("stmdb", "stmfd") and operands.startswith("sp!")):
+        words, doubles = register_count(operands)
+        f.frame += 4 * words + 8 * doubles
+    elif base == "vpush":
+        words, doubles = register_count(operands)
+        f.frame += 4 * words + 8 * doubles
+        f.uses_fpu = True
+    elif base in ("sub", "subw") and operands.startswith("sp"):
+        value = immediate(operands)
+        if value is None:
+            f.dynamic = True   # sub sp, rN
+        else:
+            f.frame += value
+    elif base in ("add", "addw") and operands.startswith("sp") and "#-" in operands:
+        f.frame += -immediate(operands)
+    elif (base == "add" and operands.startswith("sp") and immediate(operands) is None) \
+            or (base == "mov" and operands.startswith("sp,")):
+        # add sp, rN (Thumb1 large frames, ldr rN, =-N) and mov sp, rN
+        f.dynamic = True
+    elif base in ("bl", "blx") or base in BRANCHES or mnemonic in BRANCHES:
+        # branches to the own start are loops, calls to it recursion; branches into the
+        # middle of a function are filtered when the graph is resolved
+        target = TARGET_PATTERN.match(operands)
+        if target:
+            address = int(target.group(1), 16)
+            if base in ("bl", "blx") or address != f.address:
+                f.calls.add(address)
+        elif base == "blx":
+            f.indirect = True
+    elif base == "bx" and operands != "lr":
+        f.indirect = True
+
+
+def disassemble(elf_file: str, objdump: str) -> str:
+    return subprocess.run([objdump, "-d", "-C", "--no-show-raw-insn", elf_file],
+                          capture_output=True, text=True, check=True).stdout
+
+
+def vector_table(elf_file: str, objdump: str) -> List[int]:
+    """Words of the .vectors section, entry 0 is the initial stack pointer."""
+    out = subprocess.run([objdump, "-s", "-j", ".vectors", elf_file],
+                         capture_output=True, text=True, check=True).stdout
+    words: List[int] = []
+    for line in out.splitlines():
+        match = re.match(r'^\s*[0-9a-fA-F]+\s+((?:[0-9a-fA-F]{1,8}\s){1,4})', line + " ")
+        if not match or "Contents" in line:
+            continue
+        for word in match.group(1).split():
+            if len(word) == 8:
+                # dump is little endian byte order
+                words.append(int.from_bytes(bytes.fromhex(word), "little"))
+    return words
+
+
+class Analysis:
+    """Worst-case stack depth per root with warnings about unbounded constructs."""
+
+    def __init__(self, functions: Dict[int, Function]) -> None:
+        self.functions = functions
+        self.depths: Dict[int, int] = {}
+        self.warnings: List[str] = []
+        self._reported: Set[str] = set()
+
+    def warn(self, key: str, message: str) -> None:
+        if key not in self._reported:
+            self._reported.add(key)
+            self.warnings.append(message)
+
+    def depth(self, address: int, path: Optional[List[int]] = None) -> int:
+        """Deepest stack use of the function at address including its callees."""
+        if address in self.depths:
+            return self.depths[address]
+        path = path or []
+        f = self.functions[address]
+        if address in path:
+            cycle = [self.functions[a].name for a in path[path.index(address):]] + [f.name]
+            self.warn("recursion:" + f.name, "recursion not bounded: " + " -> ".join(cycle))
+            return 0
+        if f.indirect:
+            self.warn("indirect:" + f.name, f"indirect call or jump in '{f.name}' not counted")
+        if f.dynamic:
+            self.warn("dynamic:" + f.name, f"dynamic stack allocation in '{f.name}' not counted")
+        callees = sorted(c for c in f.calls if c in self.functions)
+        deepest = max((self.depth(c, path + [address]) for c in callees), default=0)
+        self.depths[address] = f.frame + deepest
+        return self.depths[address]
+
+    def root(self, address: int) -> Optional[Function]:
+        return self.functions.get(address & ~1)
+
+    def uses_fpu(self) -> bool:
+        return any(f.uses_fpu for f in self.functions.values())
+
+
+class Result:
+    def __init__(self, reset: int, isrs: List[Tuple[str, int]], frame: int,
+                 levels: Optional[int], warnings: List[str]) -> None:
+        self.reset = reset
+        self.isrs = sorted(isrs, key=lambda i: -i[1])
+        self.exception_frame = frame
+        self.levels = levels
+        self.warnings = warnings
+
+    @property
+    def nested(self) -> List[Tuple[str, int]]:
+        """ISRs assumed to be active at the same time."""
+        return self.isrs if self.levels is None else self.isrs[:self.levels]
+
+    @property
+    def bound(self) -> int:
+        return self.reset + sum(d + self.exception_frame for _, d in self.nested)
+
+
+def analyze(elf_file: str, objdump: str, levels: Optional[int] = None) -> Result:
+    analysis = Analysis(parse_disassembly(disassemble(elf_file, objdump)))
+    vectors = vector_table(elf_file, objdump)
+    if len(vectors) < 2:
+        raise RuntimeError(f"no vector table (.vectors) found in '{elf_file}'")
+
+    reset = analysis.root(vectors[1])
+    reset_depth = analysis.depth(reset.address) if reset else 0
+
+    isrs: List[Tuple[str, int]] = []
+    seen: Set[int] = {vectors[1] & ~1}
+    for address in vectors[2:]:
+        if address == 0 or (address & ~1) in seen:
+            continue
+        seen.add(address & ~1)
+        f = analysis.root(address)
+        if f is not None:
+            isrs.append((f.name, analysis.depth(f.address)))
+
+    frame = EXCEPTION_FRAME_FPU if analysis.uses_fpu() else EXCEPTION_FRAME
+    return Result(reset_depth, isrs, frame, levels, analysis.warnings)
+
+
+def report(result: Result, top: int = 10) -> str:
+    lines = [f"worst case stack: {result.bound} bytes",
+             f"  reset/main path: {result.reset} bytes",
+             f"  {len(result.nested)} nested ISRs of {len(result.isrs)}, "
+             f"{result.exception_frame} bytes exception frame each"]
+    for name, depth in result.nested[:top]:
+        lines.append(f"    {depth + result.exception_frame:>6}  {name}")
+    if result.levels is None and len(result.isrs) > 1:
+        lines.append("  every ISR assumed at its own priority level, "
+                     "pass the priority levels in use for a tighter bound")
+    return "\n".join(lines)
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Worst-case stack bound of a Cortex-M ELF")
+    parser.add_argument("elf", help="linked firmware ELF")
+    parser.add_argument("--objdump", default="arm-none-eabi-objdump",
+                        help="objdump or llvm-objdump (default: arm-none-eabi-objdump)")
+    parser.add_argument("--priority-levels", type=int, default=None,
+                        help="number of NVIC preemption levels in use (default: every ISR nests)")
+    args = parser.parse_args()
+
+    try:
+        result = analyze(args.elf, args.objdump, args.priority_levels)
+    except (OSError, RuntimeError, subprocess.CalledProcessError) as e:
+        print(f"Error: {e}", file=sys.stderr)
+        sys.exit(1)
+
+    print(report(result))
+    for w in result.warnings:
+        print(f"Warning: {w}", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
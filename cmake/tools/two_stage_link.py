@@ -3,6 +3,16 @@ import subprocess
 import os
 from linker_utils import get_memory_regions, find_region_for_address, parse_size
 
+# --kvasir-stack-analysis=<objdump>[,<priority levels>] is consumed here and not passed
+# to the linker: the step1 ELF is analyzed and the bound reported against MIN_STACK_SIZE.
+# With priority levels MIN_STACK_SIZE is raised to the bound, without them the bound
+# assumes every ISR nests and a shortfall is only a warning.
+stack_analysis = None
+for a in list(sys.argv):
+    if a.startswith("--kvasir-stack-analysis="):
+        stack_analysis = a.split("=", 1)[1]
+        sys.argv.remove(a)
+
 cnt = 0
 ocnt = 0
 rcnt = 0
@@ -108,6 +118,35 @@ ramsize = parseSize(sys.argv[rcnt])
 heapsize = parseSize(sys.argv[hcnt])
 minstacksize = parseSize(sys.argv[mcnt])
 
+if stack_analysis:
+    from stack_analysis import analyze, report
+    objdump, _, levels = stack_analysis.partition(",")
+    try:
+        result = analyze(name + ".step1", objdump, int(levels) if levels else None)
+    except (OSError, RuntimeError, subprocess.CalledProcessError) as e:
+        print(f"[two_stage_link.py] WARNING: stack analysis failed: {e}", file=sys.stderr)
+    else:
+        for w in result.warnings:
+            print(f"[two_stage_link.py] WARNING: stack analysis: {w}", file=sys.stderr)
+        bound = (result.bound + 7) & ~7
+        base = os.path.basename(name)
+        print(f"[two_stage_link.py] {base}: " + report(result, 3).replace("\n", "\n    "))
+        if bound <= minstacksize:
+            print(f"[two_stage_link.py] {base}: MIN_STACK_SIZE {minstacksize}, analyzed bound {bound}, "
+                  f"headroom {minstacksize - bound} bytes")
+        elif result.levels is None:
+            # every ISR counted as nested, far above the real worst case on most firmware
+            print(f"[two_stage_link.py] WARNING: {base}: analyzed bound {bound} exceeds MIN_STACK_SIZE "
+                  f"{minstacksize} by {bound - minstacksize} bytes if every ISR nests, set "
+                  f"STACK_ANALYSIS_PRIORITY_LEVELS to size the stack by the analysis", file=sys.stderr)
+        else:
+            print(f"[two_stage_link.py] {base}: MIN_STACK_SIZE {minstacksize} raised "
+                  f"to the analyzed bound {bound}")
+            minstacksize = bound
+            marg = sys.argv[mcnt].split("=")
+            marg[-1] = str(minstacksize)
+            sys.argv[mcnt] = '='.join(marg)
+
 stack_size_extra = (ramsize - (size+minstacksize+heapsize + int(ramsize/256)))
 
 earg = sys.argv[ecnt].split("=")
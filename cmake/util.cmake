@@ -29,7 +29,18 @@ function(add_clean_file target file)
     set_target_properties(${target} PROPERTIES ADDITIONAL_CLEAN_FILES "${new_additional_clean_files}")
 endfunction()
 
+# Per-symbol sizes are written to <target>.size.json. KVASIR_SIZE_BREAKDOWN=N prints the
+# N largest namespaces, template families and symbols; KVASIR_SIZE_BASELINE_DIR points
+# to the build directory of a previous build to print what grew since.
 function(print_size target linker_file)
+    set(size_json "${CMAKE_CURRENT_BINARY_DIR}/${target}.size.json")
+    set(size_args --nm "${CMAKE_NM}" --json "${size_json}")
+    if(KVASIR_SIZE_BREAKDOWN)
+        list(APPEND size_args --breakdown ${KVASIR_SIZE_BREAKDOWN})
+    endif()
+    if(KVASIR_SIZE_BASELINE_DIR)
+        list(APPEND size_args --diff "${KVASIR_SIZE_BASELINE_DIR}/${target}.size.json")
+    endif()
     add_custom_command(
         TARGET ${target}
         POST_BUILD
@@ -37,8 +48,9 @@ function(print_size target linker_file)
         COMMAND
             ${Python3_EXECUTABLE} -X pycache_prefix=${CMAKE_BINARY_DIR}/__pycache__
             ${kvasir_cmake_dir}/tools/pretty_size.py "${CMAKE_SIZE}" "${CMAKE_CURRENT_BINARY_DIR}/${target}.elf"
-            "${TARGET_FLASH_SIZE}" "${TARGET_RAM_SIZE}" "${TARGET_EEPROM_SIZE}" "${linker_file}"
+            "${TARGET_FLASH_SIZE}" "${TARGET_RAM_SIZE}" "${TARGET_EEPROM_SIZE}" "${linker_file}" ${size_args}
         COMMENT "Print memory usage for ${target}")
+    add_clean_file(${target} ${size_json})
 endfunction()
 
 function(check_undefined_refs target)
@@ -53,7 +65,9 @@ endfunction()
 
 function(generate_object target suffix type)
 
-    list(TRANSFORM TARGET_EXTRA_FLASH_SECTIONS PREPEND "--only-section=" OUTPUT_VARIABLE extra_flash_sections)
+    # load images of the optional RAM banks (linker/common_fast_ram.ld, common_cold_ram.ld)
+    set(flash_sections .fastData .coldData ${TARGET_EXTRA_FLASH_SECTIONS})
+    list(TRANSFORM flash_sections PREPEND "--only-section=" OUTPUT_VARIABLE extra_flash_sections)
 
     add_custom_command(
         TARGET ${target}
@@ -123,7 +137,9 @@ function(generate_object target suffix type)
 endfunction()
 
 function(generate_lst target)
-    list(TRANSFORM TARGET_EXTRA_FLASH_SECTIONS PREPEND "--section=" OUTPUT_VARIABLE extra_flash_sections)
+    # load images of the optional RAM banks (linker/common_fast_ram.ld, common_cold_ram.ld)
+    set(flash_sections .fastData .coldData ${TARGET_EXTRA_FLASH_SECTIONS})
+    list(TRANSFORM flash_sections PREPEND "--section=" OUTPUT_VARIABLE extra_flash_sections)
 
     add_custom_command(
         TARGET ${target}
@@ -300,6 +316,9 @@ function(
     add_target_linker_dependency(${name} ${kvasir_cmake_dir}/../linker/common_ram.ld)
     add_target_linker_dependency(${name} ${kvasir_cmake_dir}/../linker/common_ram_only.ld)
     add_target_linker_dependency(${name} ${kvasir_cmake_dir}/../linker/common_eeprom.ld)
+    add_target_linker_dependency(${name} ${kvasir_cmake_dir}/../linker/common_fast_ram.ld)
+    add_target_linker_dependency(${name} ${kvasir_cmake_dir}/../linker/common_dma_ram.ld)
+    add_target_linker_dependency(${name} ${kvasir_cmake_dir}/../linker/common_cold_ram.ld)
 
     # Section body include files
     add_target_linker_dependency(${name} ${kvasir_cmake_dir}/../linker/common_text_body.inc.ld)
@@ -314,6 +333,7 @@ function(
     add_target_linker_dependency(${name} ${linker_file})
     add_target_linker_dependency(${name} ${kvasir_cmake_dir}/tools/two_stage_link.py)
     add_target_linker_dependency(${name} ${kvasir_cmake_dir}/tools/linker_utils.py)
+    add_target_linker_dependency(${name} ${kvasir_cmake_dir}/tools/stack_analysis.py)
     add_target_linker_dependency(${name} ${kvasir_cmake_dir}/tools/find_undefined_refs.py)
 
     get_filename_component(linker_file_path ${linker_file} ABSOLUTE)
@@ -471,8 +491,8 @@ function(target_configure_kvasir target)
         PARSE_ARGV
         1
         PARSED_ARGS
-        "USE_LOG;NOT_USE_ASSERT;ENABLE_SELF_OVERRIDE;USE_SANITIZER"
-        "LOG;MIN_STACK_SIZE;HEAP_SIZE;OPTIMIZATION_STRATEGY;LINKER_FILE;LINKER_FILE_TEMPLATE;APPLICATION;BOOTLOADER;BOOTLOADER_SIZE"
+        "USE_LOG;NOT_USE_ASSERT;ENABLE_SELF_OVERRIDE;USE_SANITIZER;STACK_ANALYSIS"
+        "LOG;MIN_STACK_SIZE;HEAP_SIZE;OPTIMIZATION_STRATEGY;LINKER_FILE;LINKER_FILE_TEMPLATE;APPLICATION;BOOTLOADER;BOOTLOADER_SIZE;STACK_ANALYSIS_PRIORITY_LEVELS;SYMBOL_ORDERING_FILE"
         "")
 
     if(PARSED_ARGS_UNPARSED_ARGUMENTS)
@@ -575,6 +595,32 @@ function(target_configure_kvasir target)
     endif()
 
     kvasir_set_target_property(${target} ASSERT ${USE_ASSERT})
+
+    # worst-case stack bound from the disassembly of the first link stage, reported
+    # against MIN_STACK_SIZE; with STACK_ANALYSIS_PRIORITY_LEVELS (NVIC preemption
+    # levels in use) it also raises MIN_STACK_SIZE for the second stage (see
+    # tools/stack_analysis.py)
+    if(PARSED_ARGS_STACK_ANALYSIS AND CMAKE_CROSSCOMPILING)
+        set(stack_analysis_arg "--kvasir-stack-analysis=${CMAKE_OBJDUMP}")
+        if(PARSED_ARGS_STACK_ANALYSIS_PRIORITY_LEVELS)
+            set(stack_analysis_arg "${stack_analysis_arg},${PARSED_ARGS_STACK_ANALYSIS_PRIORITY_LEVELS}")
+        else()
+            message(STATUS "${target}: STACK_ANALYSIS without STACK_ANALYSIS_PRIORITY_LEVELS only reports the bound")
+        endif()
+        target_link_options(${target} PRIVATE ${stack_analysis_arg})
+    endif()
+
+    # profile guided placement of hot functions, see tools/gen_symbol_order.py
+    if(PARSED_ARGS_SYMBOL_ORDERING_FILE AND CMAKE_CROSSCOMPILING)
+        get_filename_component(symbol_ordering_file ${PARSED_ARGS_SYMBOL_ORDERING_FILE} ABSOLUTE)
+        if(CMAKE_LINKER MATCHES "lld")
+            target_link_options(${target} PRIVATE "${LINKER_PREFIX}--symbol-ordering-file=${symbol_ordering_file}"
+                                "${LINKER_PREFIX}--no-warn-symbol-ordering")
+            add_target_linker_dependency(${target} ${symbol_ordering_file})
+        else()
+            message(WARNING "${target}: SYMBOL_ORDERING_FILE needs lld, ignored; use [[gnu::hot]] instead")
+        endif()
+    endif()
     target_add_tidy_flags(${target})
     target_add_cppcheck_flags(${target})
 
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "kvasir/Atomic/Policies.hpp"
+
+#if defined(__arm__) && !defined(__ARM_FEATURE_LDREX)
+    #include "kvasir/Atomic/Atomic.hpp"
+#endif
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace Kvasir { namespace Atomic {
+
+    // Bounded multi producer, single consumer queue (D. Vyukov's ring with a sequence
+    // number per slot): producers claim a slot by CAS on the write index and publish
+    // it through the slot sequence, so several ISRs (or cores) can push into one queue
+    // without masking interrupts. Only one consumer may call pop_into/empty.
+    //
+    // ARMv6-M has no CAS, there the slot is claimed under the global InterruptGuard
+    // (the payload copy still runs with interrupts enabled) and OrderingPolicyMultiCore
+    // is not available.
+    template<typename TDataType,
+             std::size_t Size,
+             typename TOverflowPolicy = OverFlowPolicyAssert,
+             typename TOrdering       = OrderingPolicySingleCore>
+    struct MpscQueue {
+        static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "Size must be a power of two");
+        static_assert(Size <= (std::uint32_t{1} << 31), "Size to big");
+#if defined(__arm__) && !defined(__ARM_FEATURE_LDREX)
+        static_assert(!std::is_same_v<TOrdering, OrderingPolicyMultiCore>,
+                      "no multi core mode without exclusive monitor");
+#endif
+
+        // sequences are stored relative to the slot index, so the initial state is all
+        // zero and the queue goes to .bss
+        struct Slot {
+            std::atomic<std::uint32_t> sequence;
+            TDataType                  data;
+        };
+
+        static constexpr std::uint32_t mask{Size - 1};
+
+        static constexpr auto indexAlignment
+          = Detail::indexAlignment<TOrdering, std::atomic<std::uint32_t>>;
+        alignas(indexAlignment) std::atomic<std::uint32_t> write_{};
+        alignas(indexAlignment) std::atomic<std::uint32_t> read_{};
+        alignas(Detail::indexAlignment<TOrdering, Slot>) std::array<Slot, Size> slots_{};
+
+        static std::uint32_t sequence(Slot const&   slot,
+                                      std::uint32_t pos) {
+            auto const s = slot.sequence.load(TOrdering::load) + (pos & mask);
+            TOrdering::acquire();
+            return s;
+        }
+
+        static void publish(Slot&         slot,
+                            std::uint32_t pos,
+                            std::uint32_t s) {
+            TOrdering::release();
+            slot.sequence.store(s - (pos & mask), TOrdering::store);
+        }
+
+        // producers, any number, any context
+        void push(TDataType const& in) {
+            if(!try_push(in)) { TOverflowPolicy{}(); }
+        }
+
+        bool try_push(TDataType const& in) {
+#if defined(__arm__) && !defined(__ARM_FEATURE_LDREX)
+            std::uint32_t pos;
+            {
+                Nvic::InterruptGuard<Nvic::Global> guard;
+                pos = write_.load(std::memory_order_relaxed);
+                if(sequence(slots_[pos & mask], pos) != pos) { return false; }   // full
+                write_.store(pos + 1, std::memory_order_relaxed);
+            }
+#else
+            auto pos = write_.load(std::memory_order_relaxed);
+            while(true) {
+                auto const diff
+                  = static_cast<std::int32_t>(sequence(slots_[pos & mask], pos) - pos);
+                if(diff == 0) {
+                    if(write_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if(diff < 0) {
+                    return false;   // full, the consumer has not released the slot yet
+                } else {
+                    // claimed by another producer
+                    pos = write_.load(std::memory_order_relaxed);
+                }
+            }
+#endif
+            auto& slot = slots_[pos & mask];
+            slot.data  = in;
+            publish(slot, pos, pos + 1);
+            return true;
+        }
+
+        // consumer only
+        bool pop_into(TDataType& out) {
+            auto const pos  = read_.load(std::memory_order_relaxed);
+            auto&      slot = slots_[pos & mask];
+            if(sequence(slot, pos) != pos + 1) { return false; }
+            out = slot.data;
+            publish(slot, pos, pos + Size);
+            read_.store(pos + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // consumer only; also true while the oldest claimed slot is still being written
+        bool empty() const {
+            auto const pos = read_.load(std::memory_order_relaxed);
+            return sequence(slots_[pos & mask], pos) != pos + 1;
+        }
+
+        // claimed slots, including the ones still being written
+        std::size_t size() const {
+            return write_.load(std::memory_order_relaxed) - read_.load(std::memory_order_relaxed);
+        }
+
+        constexpr std::size_t max_size() const { return Size; }
+    };
+}}   // namespace Kvasir::Atomic
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+
+#ifndef __arm__
+    #include <thread>
+#endif
+
+namespace Kvasir { namespace Atomic {
+
+    // OverFlowPolicyAssert is the default action which is taken if
+    // an overflow occurs. The user is encurraged to provide their
+    // own policy which call reset or some other error handler
+    struct OverFlowPolicyAssert {
+        [[noreturn]] void operator()() { assert(false); }
+    };
+
+    struct OverFlowPolicyIgnore {
+        void operator()() {}
+    };
+
+    // Memory ordering of the lock free containers. Indices and sequence numbers are
+    // accessed with load/store/exchange order, acquire()/release() sit between them and
+    // the payload accesses; alignment separates producer and consumer indices. wake() is
+    // called by the producer after publishing, for consumers sleeping in Detail::sleep.
+
+    // Default: producers and consumers are ISRs and thread code on one core, only the
+    // compiler may reorder. Relaxed accesses and signal fences, no barrier instructions.
+    struct OrderingPolicySingleCore {
+        static constexpr auto        load{std::memory_order_relaxed};
+        static constexpr auto        store{std::memory_order_relaxed};
+        static constexpr auto        exchange{std::memory_order_relaxed};
+        static constexpr std::size_t alignment{1};   // no padding
+
+        static void acquire() { std::atomic_signal_fence(std::memory_order_acquire); }
+
+        static void release() { std::atomic_signal_fence(std::memory_order_release); }
+
+        // sets the event register, also covers a push between the consumer's empty
+        // check and its WFE
+        template<typename T>
+        static void wake(std::atomic<T>& index) {
+#ifdef __arm__
+            (void)index;
+            asm volatile("sev" ::: "memory");
+#else
+            index.notify_all();
+#endif
+        }
+    };
+
+    // Producer and consumer on different cores (or host threads): acquire loads and
+    // release stores (DMB on Cortex-M), indices on separate cache lines.
+    struct OrderingPolicyMultiCore {
+        static constexpr auto load{std::memory_order_acquire};
+        static constexpr auto store{std::memory_order_release};
+        static constexpr auto exchange{std::memory_order_acq_rel};
+#ifdef __arm__
+        static constexpr std::size_t alignment{32};   // Cortex-M7/M55/M85 D-cache line
+#else
+        static constexpr std::size_t alignment{64};
+#endif
+
+        static void acquire() {}
+
+        static void release() {}
+
+        // the store has to be visible to the other core before it wakes up; the other
+        // core only sees the event if the chip connects TXEV/RXEV between the cores
+        template<typename T>
+        static void wake(std::atomic<T>& index) {
+#ifdef __arm__
+            (void)index;
+            asm volatile("dsb\n\tsev" ::: "memory");
+#else
+            index.notify_all();
+#endif
+        }
+    };
+
+    namespace Detail {
+        // alignment of the producer and the consumer owned members
+        template<typename TOrdering,
+                 typename T>
+        inline constexpr std::size_t indexAlignment = std::max(TOrdering::alignment, alignof(T));
+
+        // Consumer side: sleeps until index changes from old, a wake() or (on Cortex-M)
+        // any interrupt. May return early, callers check their condition again.
+        template<typename T>
+        void sleep([[maybe_unused]] std::atomic<T> const& index,
+                   [[maybe_unused]] T                     old) {
+#ifdef __arm__
+            asm volatile("wfe" ::: "memory");
+#else
+            index.wait(old, std::memory_order_relaxed);
+#endif
+        }
+
+        // Consumer side: short sleep without a wake up guarantee, for waits with a
+        // deadline. On Cortex-M the interrupt of the clock ends the WFE.
+        inline void doze() {
+#ifdef __arm__
+            asm volatile("wfe" ::: "memory");
+#else
+            std::this_thread::yield();
+#endif
+        }
+    }   // namespace Detail
+
+}}   // namespace Kvasir::Atomic
@@ -1,23 +1,24 @@
 #pragma once
 
+#include "kvasir/Atomic/Policies.hpp"
 #include "kvasir/Mpl/Utility.hpp"
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
 
 namespace Kvasir { namespace Atomic {
 
-    // OverFlowPolicyAssert is the default action which is taken if
-    // an overflow occurs. The user is encurraged to provide their
-    // own policy which call reset or some other error handler
-    struct OverFlowPolicyAssert {
-        [[noreturn]] void operator()() { assert(false); }
-    };
-
-    struct OverFlowPolicyIgnore {
-        void operator()() {}
-    };
-
     namespace Detail {
         using namespace MPL;
 
@@ -39,39 +40,170 @@ namespace Kvasir { namespace Atomic {
         template<std::size_t Size>
         using GetIndexTypeT = typename GetIndexType<Size, void>::type;
 
+        // a region of the ring buffer, second is only non-empty if the region wraps
+        template<typename T>
+        struct RingSpans {
+            std::span<T> first;
+            std::span<T> second;
+
+            std::size_t size() const { return first.size() + second.size(); }
+
+            bool empty() const { return size() == 0; }
+        };
+
     }   // namespace Detail
 
-    template<typename TDataType, std::size_t Size, typename TOverflowPolicy = OverFlowPolicyAssert>
+    // Single producer, single consumer ring. TOrdering selects between ISR and thread
+    // code on one core (OrderingPolicySingleCore, no barriers) and producer and consumer
+    // on different cores or host threads (OrderingPolicyMultiCore, acquire/release and
+    // head and tail on separate cache lines), see Policies.hpp.
+    //
+    // The elements live in uninitialized storage and are only constructed between head
+    // and tail, so TDataType needs no default constructor and big queues cost nothing
+    // at boot. Zero copy operations need a trivially copyable TDataType, range
+    // operations copy other types element by element.
+    // A queue in .noInit ([[KVASIR_NO_INIT]] static Queue<...> q;) is not even zeroed
+    // at startup and must be init() before first use.
+    // OverFlowPolicyStats (QueueStats.hpp) records pushes, overflows and the high water
+    // mark of a queue.
+    template<typename TDataType,
+             std::size_t Size,
+             typename TOverflowPolicy = OverFlowPolicyAssert,
+             typename TOrdering       = OrderingPolicySingleCore>
     struct Queue {
         using IndexType = Detail::GetIndexTypeT<Size>;
         static_assert(std::numeric_limits<IndexType>::max() > Size,
                       "Size to big");
-        static constexpr auto       load_memory_order{std::memory_order_relaxed};
-        static constexpr auto       store_memory_order{std::memory_order_relaxed};
-        static constexpr auto       fence_memory_order{std::memory_order_release};
-        std::atomic<IndexType>      head_{};
-        std::atomic<IndexType>      tail_{};
-        std::array<TDataType, Size> data_{};
+        static constexpr auto indexAlignment
+          = Detail::indexAlignment<TOrdering, std::atomic<IndexType>>;
+        alignas(indexAlignment) std::atomic<IndexType> head_{};
+        alignas(indexAlignment) std::atomic<IndexType> tail_{};
+        alignas(Detail::indexAlignment<TOrdering, TDataType>)
+          std::byte storage_[Size * sizeof(TDataType)];
+
+        ~Queue() = default;
+
+        ~Queue()
+          requires(!std::is_trivially_destructible_v<TDataType>)
+        {
+            clear();
+        }
+
+        // first slot; elements are only alive between head and tail
+        TDataType* data() {
+            return reinterpret_cast<TDataType*>(storage_);   //NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        }
+
+        TDataType const* data() const {
+            return reinterpret_cast<TDataType const*>(storage_);   //NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        }
+
+        // a constructed element
+        TDataType& element(IndexType i) { return *std::launder(data() + i); }
+
+        TDataType const& element(IndexType i) const { return *std::launder(data() + i); }
+
+        // own index, only written by the calling side
+        static IndexType ownIndex(std::atomic<IndexType> const& index) {
+            return index.load(std::memory_order_relaxed);
+        }
+
+        // index of the other side, orders the following payload accesses after it
+        static IndexType otherIndex(std::atomic<IndexType> const& index) {
+            auto const i = index.load(TOrdering::load);
+            TOrdering::acquire();
+            return i;
+        }
+
+        // orders the payload accesses before it
+        static void publish(std::atomic<IndexType>& index,
+                            IndexType               i) {
+            TOrdering::release();
+            index.store(i, TOrdering::store);
+        }
+
+        // power of two sizes wrap the indices by masking
+        static constexpr bool powerOfTwo = (Size & (Size - 1)) == 0;
 
         static constexpr IndexType distance(IndexType head,
                                             IndexType tail) {
-            auto d = int(unsigned(tail) - unsigned(head));
-            if(d < 0) { d += Size; }
-            return IndexType(d);
+            if constexpr(powerOfTwo) {
+                return IndexType((unsigned(tail) - unsigned(head)) & (Size - 1));
+            } else {
+                auto d = int(unsigned(tail) - unsigned(head));
+                if(d < 0) { d += Size; }
+                return IndexType(d);
+            }
+        }
+
+        // n <= Size
+        static constexpr IndexType advance(IndexType   in,
+                                           std::size_t n) {
+            if constexpr(powerOfTwo) {
+                return IndexType((in + n) & (Size - 1));
+            } else {
+                auto const i = in + n;
+                return IndexType(i >= Size ? i - Size : i);
+            }
+        }
+
+        static constexpr IndexType next(IndexType in) { return advance(in, 1); }
+
+        // producer commit: publishes tail after n new elements and wakes a consumer
+        // sleeping in pop_wait()
+        void publishTail(std::size_t n,
+                         IndexType   head,
+                         IndexType   tail) {
+            publish(tail_, tail);
+            TOrdering::wake(tail_);
+            pushed(n, head, tail);
+        }
+
+        // instrumenting overflow policies (OverFlowPolicyStats) keep their statistics
+        // per capacity
+        static void overflow() {
+            if constexpr(requires { TOverflowPolicy::template overflowed<Size - 1>(); }) {
+                TOverflowPolicy::template overflowed<Size - 1>();
+            } else {
+                TOverflowPolicy{}();
+            }
+        }
+
+        // occupancy hook of instrumenting overflow policies (OverFlowPolicyStats)
+        static void pushed(std::size_t n,
+                           IndexType   head,
+                           IndexType   tail) {
+            if constexpr(requires { TOverflowPolicy::template pushed<Size - 1>(n, n); }) {
+                TOverflowPolicy::template pushed<Size - 1>(n, distance(head, tail));
+            }
+        }
+
+        template<typename T>
+        static Detail::RingSpans<T> spans(T*          data,
+                                          IndexType   start,
+                                          std::size_t n) {
+            std::size_t const first = std::min(n, Size - start);
+            return {std::span<T>{data + start, first}, std::span<T>{data, n - first}};
         }
 
-        static constexpr IndexType next(IndexType in) { return (in + 1) % Size; }
+        using WriteSpans = Detail::RingSpans<TDataType>;
+        using ReadSpans  = Detail::RingSpans<TDataType const>;
 
-        void push(TDataType in) {
-            auto const tail     = tail_.load(load_memory_order);
-            auto const head     = head_.load(load_memory_order);
+        void push(TDataType const& in) { emplace(in); }
+
+        void push(TDataType&& in) { emplace(std::move(in)); }
+
+        // constructs the element in place
+        template<typename... Args>
+        void emplace(Args&&... args) {
+            auto const tail     = ownIndex(tail_);
+            auto const head     = otherIndex(head_);
             auto       nextTail = next(tail);
             if(head != nextTail) {
-                data_[tail] = in;   //NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
-                std::atomic_signal_fence(fence_memory_order);
-                tail_.store(nextTail, store_memory_order);   // commit
+                std::construct_at(data() + tail, std::forward<Args>(args)...);
+                publishTail(1, head, nextTail);   // commit
             } else {
-                TOverflowPolicy{}();
+                overflow();
             }
         }
 
@@ -80,80 +212,204 @@ namespace Kvasir { namespace Atomic {
                    std::is_same<std::decay_t<decltype(*std::declval<TRange>().begin())>,
                                 TDataType>::value>>
         void push(TRange const& range) {
-            auto       tail = tail_.load(load_memory_order);
-            auto const head = head_.load(load_memory_order);
-            if(range.size() < Size - distance(head, tail)) {
-                auto       begin = range.begin();
-                auto const end   = range.end();
-                while(begin != end) {
-                    data_[tail]
-                      = *begin++;   //NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
-                    tail = next(tail);
-                }
-                std::atomic_signal_fence(fence_memory_order);
-                tail_.store(tail, store_memory_order);   // commit
+            auto const        tail = ownIndex(tail_);
+            auto const        head = otherIndex(head_);
+            std::size_t const n    = range.size();
+            if(n < Size - distance(head, tail)) {
+                // at most two contiguous segments, memmove for trivially copyable types
+                auto const segments = spans<TDataType>(data(), tail, n);
+                auto const rest     = copyInto(range.begin(), segments.first);
+                copyInto(rest, segments.second);
+                publishTail(n, head, advance(tail, n));   // commit
             } else {
-                TOverflowPolicy{}();
+                overflow();
             }
         }
 
+        // constructs the slots of a free segment from in, returns the rest of in
+        template<typename TIterator>
+        static TIterator copyInto(TIterator                   in,
+                                  std::span<TDataType> const& slots) {
+            if constexpr(std::is_trivially_copyable_v<TDataType>) {
+                return std::ranges::copy_n(in, slots.size(), slots.data()).in;
+            } else {
+                return std::ranges::uninitialized_copy_n(in,
+                                                         slots.size(),
+                                                         slots.begin(),
+                                                         slots.end())
+                  .in;
+            }
+        }
+
+        // Zero copy producer side: up to n free slots (fewer if the queue is fuller) to
+        // be filled in place, e.g. by DMA, then published with commit(). Producer only.
+        WriteSpans reserve(std::size_t n = Size - 1) {
+            static_assert(std::is_trivially_copyable_v<TDataType>,
+                          "zero copy operations need a trivially copyable type");
+            auto const tail = ownIndex(tail_);
+            auto const head = otherIndex(head_);
+            return spans<TDataType>(data(), tail, std::min(n, Size - 1 - distance(head, tail)));
+        }
+
+        // publishes the first n slots of the last reserve()
+        void commit(std::size_t n) {
+            auto const tail = ownIndex(tail_);
+            auto const head = head_.load(std::memory_order_relaxed);
+            assert(n < Size - distance(head, tail));
+            publishTail(n, head, advance(tail, n));   // commit
+        }
+
+        // moves the element out
         bool pop_into(TDataType& out) {
-            auto const tail = tail_.load(load_memory_order);
-            auto const head = head_.load(load_memory_order);
+            auto const tail = otherIndex(tail_);
+            auto const head = ownIndex(head_);
             if(head == tail) { return false; }
-            out = data_[head];   //NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
-            std::atomic_signal_fence(fence_memory_order);
-            head_.store(next(head), store_memory_order);   // commit
+            out = std::move(element(head));
+            std::destroy_at(&element(head));
+            publish(head_, next(head));   // commit
             return true;
         }
 
+        // polls before pop_wait() sleeps, keeps the latency of a spinning consumer for
+        // elements that arrive right away
+        static constexpr std::size_t waitSpins{64};
+
+        // Consumer: blocks until an element is available instead of spinning on
+        // empty(). Sleeps with WFE on Cortex-M (woken by the SEV of every push and
+        // commit, or an interrupt) and in std::atomic::wait on the host.
+        void pop_wait(TDataType& out) {
+            for(std::size_t spin = 0; !pop_into(out); ++spin) {
+                if(spin >= waitSpins) { Detail::sleep(tail_, ownIndex(head_)); }
+            }
+        }
+
+        // pop_wait() with a deadline of a monotonic clock, false on timeout. The clock
+        // is checked after every wake up, so on Cortex-M some interrupt has to occur
+        // by the deadline (e.g. the tick of the clock) to end the WFE.
+        template<typename TClock,
+                 typename TDuration>
+        bool pop_wait_until(TDataType&                                   out,
+                            std::chrono::time_point<TClock, TDuration> const& deadline) {
+            for(std::size_t spin = 0; !pop_into(out); ++spin) {
+                if(TClock::now() >= deadline) { return false; }
+                if(spin >= waitSpins) { Detail::doze(); }
+            }
+            return true;
+        }
+
+        template<typename TClock,
+                 typename TRep,
+                 typename TPeriod>
+        bool pop_wait_for(TDataType&                                out,
+                          std::chrono::duration<TRep, TPeriod> const& timeout) {
+            return pop_wait_until(out, TClock::now() + timeout);
+        }
+
         template<typename TRange,
                  typename = std::enable_if_t<
                    std::is_same<std::decay_t<decltype(*std::declval<TRange>().begin())>,
                                 TDataType>::value>>
         bool pop_into(TRange& range) {
-            auto const tail  = tail_.load(load_memory_order);
-            auto       head  = head_.load(load_memory_order);
-            auto const lsize = distance(head, tail);
-            if(lsize < range.size()) { return false; }
-            auto       begin = range.begin();
-            auto const end   = range.end();
-            while(begin != end) {
-                *begin++
-                  = data_[head];   //NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
-                head = next(head);
-            }
-            std::atomic_signal_fence(fence_memory_order);
-            head_.store(head, store_memory_order);   // commit
+            auto const        tail = otherIndex(tail_);
+            auto const        head = ownIndex(head_);
+            std::size_t const n    = range.size();
+            if(distance(head, tail) < n) { return false; }
+            auto const segments = spans<TDataType>(data(), head, n);
+            auto const rest     = moveOutOf(segments.first, range.begin());
+            moveOutOf(segments.second, rest);
+            publish(head_, advance(head, n));   // commit
             return true;
         }
 
+        // moves the elements of a segment to out and destroys them, returns the rest of
+        // out
+        template<typename TIterator>
+        static TIterator moveOutOf(std::span<TDataType> const& elements,
+                                   TIterator                   out) {
+            if constexpr(std::is_trivially_copyable_v<TDataType>) {
+                return std::ranges::copy_n(elements.data(), elements.size(), out).out;
+            } else {
+                for(auto& e : elements) {
+                    *out = std::move(*std::launder(&e));
+                    std::destroy_at(std::launder(&e));
+                    ++out;
+                }
+                return out;
+            }
+        }
+
+        // Zero copy consumer side: all stored elements in place, e.g. for a parser,
+        // released with consume(). Consumer only.
+        ReadSpans peek() const {
+            static_assert(std::is_trivially_copyable_v<TDataType>,
+                          "zero copy operations need a trivially copyable type");
+            auto const tail = otherIndex(tail_);
+            auto const head = ownIndex(head_);
+            return spans<TDataType const>(data(), head, distance(head, tail));
+        }
+
+        // releases the first n elements of the last peek()
+        void consume(std::size_t n) {
+            auto const head = ownIndex(head_);
+            assert(n <= distance(head, tail_.load(std::memory_order_relaxed)));
+            publish(head_, advance(head, n));   // commit
+        }
+
         void pop() {
-            auto const tail = tail_.load(load_memory_order);
-            auto const head = head_.load(load_memory_order);
+            auto const tail = otherIndex(tail_);
+            auto const head = ownIndex(head_);
             if(head == tail) { return; }
-            head_.store(next(head), store_memory_order);   // commit
+            std::destroy_at(&element(head));
+            publish(head_, next(head));   // commit
         }
 
+        // front() of an empty queue; instrumenting policies provide underflow() so the
+        // consumer does not count as an overflow
+        static void underflow() {
+            if constexpr(requires { TOverflowPolicy::underflow(); }) {
+                TOverflowPolicy::underflow();
+            } else {
+                TOverflowPolicy{}();
+            }
+        }
+
+        // not empty; traps if the policy returns on an empty queue, the storage holds no
+        // element to refer to
         TDataType const& front() const {
-            auto const head = head_.load(load_memory_order);
-            if(head == tail_.load(load_memory_order)) { TOverflowPolicy{}(); }
-            TDataType const& ret
-              = data_[head];   //NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
-            return ret;
+            auto const head = ownIndex(head_);
+            if(head == otherIndex(tail_)) {
+                underflow();
+                __builtin_trap();
+            }
+            return element(head);
         }
 
         std::size_t size() const {
-            return distance(head_.load(load_memory_order), tail_.load(load_memory_order));
+            return distance(otherIndex(head_), otherIndex(tail_));
         }
 
         bool empty() const { return size() == 0; }
 
         constexpr std::size_t max_size() const { return Size - 1; }
 
+        // neither producer nor consumer may run concurrently
         void clear() {
-            head_.store(0, store_memory_order);
-            tail_.store(0, store_memory_order);
+            if constexpr(!std::is_trivially_destructible_v<TDataType>) {
+                auto const tail = tail_.load(std::memory_order_relaxed);
+                for(auto head = head_.load(std::memory_order_relaxed); head != tail;
+                    head      = next(head))
+                {
+                    std::destroy_at(&element(head));
+                }
+            }
+            init();
+        }
+
+        // empties the queue without destroying elements, for queues in .noInit whose
+        // indices are undefined after reset
+        void init() {
+            head_.store(0, TOrdering::store);
+            tail_.store(0, TOrdering::store);
         }
     };
 }}   // namespace Kvasir::Atomic
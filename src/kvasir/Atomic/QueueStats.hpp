@@ -0,0 +1,131 @@
+#pragma once
+
+#include "kvasir/Atomic/Policies.hpp"
+#include "kvasir/Util/FixedString.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+namespace Kvasir { namespace Atomic {
+
+    // Occupancy and overflow counters of one queue. Only the (single) producer writes
+    // them, so the updates are plain loads and stores: a compare for the high water
+    // mark and an increment for the counters, no read-modify-write and no guard.
+    struct QueueStats {
+        std::atomic<std::uint32_t> pushes{};      // elements pushed
+        std::atomic<std::uint32_t> overflows{};   // pushes rejected because the queue was full
+        std::atomic<std::uint32_t> highWater{};   // most elements stored at once
+
+        void pushed(std::uint32_t n,
+                    std::uint32_t occupancy) noexcept {
+            pushes.store(pushes.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+            if(occupancy > highWater.load(std::memory_order_relaxed)) {
+                highWater.store(occupancy, std::memory_order_relaxed);
+            }
+        }
+
+        void overflowed() noexcept {
+            overflows.store(overflows.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+        }
+    };
+
+    // One registry entry per instrumented queue name, collected by the linker in the
+    // kvasir_queue_stats section (see common_text_body.inc.ld).
+    struct QueueStatsEntry {
+        char const*       name;
+        std::size_t       nameSize;
+        std::size_t       capacity;
+        QueueStats const* stats;
+
+        std::string_view nameView() const noexcept { return {name, nameSize}; }
+    };
+
+    // Instrumenting overflow policy for Atomic::Queue, e.g.
+    //   Queue<std::uint8_t, 256, OverFlowPolicyStats<"uartRx">> rx;
+    // counts pushes, overflows and the high water mark, then hands overflows on to
+    // TOverflowPolicy. The statistics belong to one name and capacity, give every
+    // queue its own name: the counters assume a single producer.
+    // Report with Kvasir::Startup::printQueueStats().
+    template<FixedString Name,
+             typename TOverflowPolicy = OverFlowPolicyIgnore>
+    struct OverFlowPolicyStats {
+        // alignas keeps the compiler from over-aligning the entries, they have to form
+        // a gapless array in the section
+        template<std::size_t Capacity>
+        struct Site {
+            static inline QueueStats stats{};
+
+            [[gnu::used, gnu::section("kvasir_queue_stats")]] alignas(
+              QueueStatsEntry) static constexpr QueueStatsEntry entry{Name.data,
+                                                                    Name.view().size(),
+                                                                    Capacity,
+                                                                    std::addressof(stats)};
+        };
+
+        template<std::size_t Capacity>
+        static QueueStats& stats() noexcept {
+            // taking the address instantiates the registry entry
+            (void)std::addressof(Site<Capacity>::entry);
+            return Site<Capacity>::stats;
+        }
+
+        // called by the queue instead of operator() when a push does not fit
+        template<std::size_t Capacity>
+        static void overflowed() {
+            stats<Capacity>().overflowed();
+            TOverflowPolicy{}();
+        }
+
+        // front() of an empty queue, not counted: the statistics belong to the producer
+        static void underflow() { TOverflowPolicy{}(); }
+
+        // called by the queue after every successful push of n elements
+        template<std::size_t Capacity>
+        static void pushed(std::size_t n,
+                           std::size_t occupancy) noexcept {
+            stats<Capacity>().pushed(static_cast<std::uint32_t>(n),
+                                     static_cast<std::uint32_t>(occupancy));
+        }
+    };
+
+}}   // namespace Kvasir::Atomic
+
+#ifdef __arm__
+extern "C" {
+extern std::uintptr_t _LINKER_queue_stats_start_;
+extern std::uintptr_t _LINKER_queue_stats_end_;
+}
+#else
+// defined by the host linker for sections named like C identifiers, weak so
+// programs without any instrumented queue still link
+extern "C" {
+[[gnu::weak]] extern std::uintptr_t __start_kvasir_queue_stats;
+[[gnu::weak]] extern std::uintptr_t __stop_kvasir_queue_stats;
+}
+#endif
+
+namespace Kvasir { namespace Atomic {
+
+    // Calls f(QueueStatsEntry const&) for every instrumented queue linked into the
+    // program, in link order.
+    template<typename F>
+    void forEachQueueStats(F&& f) {
+#ifdef __arm__
+        auto const* first
+          = reinterpret_cast<QueueStatsEntry const*>(std::addressof(_LINKER_queue_stats_start_));
+        auto const* last
+          = reinterpret_cast<QueueStatsEntry const*>(std::addressof(_LINKER_queue_stats_end_));
+#else
+        auto const* first
+          = reinterpret_cast<QueueStatsEntry const*>(std::addressof(__start_kvasir_queue_stats));
+        auto const* last
+          = reinterpret_cast<QueueStatsEntry const*>(std::addressof(__stop_kvasir_queue_stats));
+#endif
+        for(; first != last; ++first) { f(*first); }
+    }
+
+}}   // namespace Kvasir::Atomic
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "kvasir/Atomic/Policies.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace Kvasir { namespace Atomic {
+
+    // Latest value sharing between one writer (e.g. an ISR producing measurements) and
+    // one reader (e.g. the main loop), without a queue and without masking interrupts.
+    // Each side owns one of three buffers, the third is the back buffer. The writer
+    // fills its buffer and swaps it with the back buffer in one exchange of the state
+    // word (back buffer index plus a fresh flag); the reader swaps its buffer with the
+    // back buffer only if that is fresh. Neither side ever waits for the other and the
+    // reader's buffer is never written while it is read, so snapshots are never torn.
+    // Values the reader does not pick up in time are overwritten by newer ones.
+    //
+    // ARMv6-M has no exclusive monitor, there the exchange is the guarded byte exchange
+    // of the atomic runtime (interrupts masked for a few instructions) and
+    // OrderingPolicyMultiCore is not available.
+    template<typename T,
+             typename TOrdering = OrderingPolicySingleCore>
+    struct TripleBuffer {
+#if defined(__arm__) && !defined(__ARM_FEATURE_LDREX)
+        static_assert(!std::is_same_v<TOrdering, OrderingPolicyMultiCore>,
+                      "no multi core mode without exclusive monitor");
+#endif
+
+        static constexpr std::uint8_t indexMask{0b011};
+        static constexpr std::uint8_t freshFlag{0b100};
+
+        // separate cache lines in the multi core mode
+        struct alignas(Detail::indexAlignment<TOrdering, T>) Buffer {
+            T value;
+        };
+
+        static constexpr auto indexAlignment
+          = Detail::indexAlignment<TOrdering, std::atomic<std::uint8_t>>;
+        std::array<Buffer, 3>                             buffers_{};
+        alignas(indexAlignment) std::atomic<std::uint8_t> state_{2};
+        alignas(indexAlignment) std::uint8_t              writer_{0};   // writer only
+        alignas(indexAlignment) std::uint8_t              reader_{1};   // reader only
+
+        // hands the own buffer over, orders the buffer accesses of both sides
+        std::uint8_t swap(std::uint8_t state) {
+            TOrdering::release();
+            auto const old = state_.exchange(state, TOrdering::exchange);
+            TOrdering::acquire();
+            return old & indexMask;
+        }
+
+        // writer: the buffer to fill in place, published with publish()
+        T& back() { return buffers_[writer_].value; }
+
+        void publish() { writer_ = swap(writer_ | freshFlag); }
+
+        void write(T const& value) {
+            back() = value;
+            publish();
+        }
+
+        // reader: picks up the latest published value, false if there is none since
+        // the last update()
+        bool update() {
+            if(!fresh()) { return false; }
+            reader_ = swap(reader_);
+            return true;
+        }
+
+        // reader: the value of the last update(), stays valid until the next one
+        T const& front() const { return buffers_[reader_].value; }
+
+        T const& read() {
+            update();
+            return front();
+        }
+
+        // reader: a value was published since the last update()
+        bool fresh() const { return (state_.load(std::memory_order_relaxed) & freshFlag) != 0; }
+    };
+}}   // namespace Kvasir::Atomic
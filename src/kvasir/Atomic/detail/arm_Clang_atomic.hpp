@@ -106,7 +106,7 @@ inline void __atomic_store_c(size_t         size,
                              void volatile* dest,
                              void const*    src,
                              int            memorder) {
-    CommonAtomic::atomic_store_mem_block(size, dest, src, memorder);
+    CommonAtomic::atomic_store_mem_block(size, dest, src, memorder, __builtin_return_address(0));
 }
 
 inline void __atomic_exchange_c(size_t         size,
@@ -114,7 +114,12 @@ inline void __atomic_exchange_c(size_t         size,
                                 void const*    val,
                                 void*          ret,
                                 int            memorder) {
-    CommonAtomic::atomic_exchange_mem_block(size, ptr, val, ret, memorder);
+    CommonAtomic::atomic_exchange_mem_block(size,
+                                            ptr,
+                                            val,
+                                            ret,
+                                            memorder,
+                                            __builtin_return_address(0));
 }
 
 inline bool __atomic_compare_exchange_c(size_t         size,
@@ -130,7 +135,8 @@ inline bool __atomic_compare_exchange_c(size_t         size,
                                                            desired,
                                                            weak,
                                                            success_memorder,
-                                                           failure_memorder);
+                                                           failure_memorder,
+                                                           __builtin_return_address(0));
 }
 
 [[gnu::used]] inline unsigned char __atomic_load_1(void const volatile* ptr,
@@ -1,7 +1,15 @@
 #pragma once
 #include "core/Nvic.hpp"
+#include "seqlock_atomic.hpp"
+
+#ifdef KVASIR_PROFILE_CRITICAL_SECTIONS
+    #include "kvasir/StartUp/CriticalSectionProfiler.hpp"
+
+    #include <source_location>
+#endif
 
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <memory>
 #include <type_traits>
@@ -34,16 +42,37 @@ namespace Kvasir { namespace Nvic {
 
     struct Global {};
 
+    // With KVASIR_PROFILE_CRITICAL_SECTIONS defined the outermost global guard measures
+    // how long interrupts stay masked and records it per call site in
+    // Startup::criticalSections (see Startup::printCriticalSections()). Without it the
+    // guard has no extra members and no source_location parameter. caller separates
+    // the call sites of a guard in shared code, see CommonAtomic::lock().
     template<typename T>
     struct InterruptGuard {
     private:
         bool oldState;
+#ifdef KVASIR_PROFILE_CRITICAL_SECTIONS
+        std::uint32_t        enter{};
+        std::source_location loc;
+        void const*          caller;
+#endif
 
     public:
-        constexpr InterruptGuard() {
+#ifdef KVASIR_PROFILE_CRITICAL_SECTIONS
+        explicit constexpr InterruptGuard(
+          std::source_location const& l = std::source_location::current(),
+          void const*                 c = nullptr)
+          : loc{l}
+          , caller{c} {
+#else
+        explicit constexpr InterruptGuard() {
+#endif
             if(!std::is_constant_evaluated()) {
                 if constexpr(std::is_same_v<Global, T>) {
                     oldState = disable_all_and_get_old_state();
+#ifdef KVASIR_PROFILE_CRITICAL_SECTIONS
+                    if(oldState) { enter = KVASIR_PROFILE_TIME_SOURCE::now(); }
+#endif
                 } else {
                     oldState = static_cast<bool>(get<0>(apply(Nvic::makeRead(T{}))));
                     apply(Nvic::makeDisable(T{}));
@@ -55,7 +84,14 @@ namespace Kvasir { namespace Nvic {
 
         InterruptGuard(InterruptGuard const&) = delete;
 
-        constexpr InterruptGuard(InterruptGuard&& other) : oldState(other.oldState) {
+        constexpr InterruptGuard(InterruptGuard&& other)
+          : oldState(other.oldState)
+#ifdef KVASIR_PROFILE_CRITICAL_SECTIONS
+          , enter{other.enter}
+          , loc{other.loc}
+          , caller{other.caller}
+#endif
+        {
             other.oldState = false;
         }
 
@@ -65,6 +101,11 @@ namespace Kvasir { namespace Nvic {
             if(this != std::addressof(other)) {
                 oldState       = other.oldState;
                 other.oldState = false;
+#ifdef KVASIR_PROFILE_CRITICAL_SECTIONS
+                enter  = other.enter;
+                loc    = other.loc;
+                caller = other.caller;
+#endif
             }
             return *this;
         }
@@ -72,6 +113,12 @@ namespace Kvasir { namespace Nvic {
         constexpr ~InterruptGuard() {
             if(oldState) {
                 if constexpr(std::is_same_v<Global, T>) {
+#ifdef KVASIR_PROFILE_CRITICAL_SECTIONS
+                    // still masked, record() and the time source need no locking
+                    Startup::criticalSections.record(loc,
+                                                     KVASIR_PROFILE_TIME_SOURCE::now() - enter,
+                                                     caller);
+#endif
                     enable_all();
                 } else {
                     apply(Nvic::makeEnable(T{}));
@@ -119,75 +166,202 @@ namespace Kvasir { namespace Nvic {
 }}   // namespace Kvasir::Nvic
 
 namespace CommonAtomic {
+
+#ifdef __ARM_FEATURE_LDREX
+// __ARM_FEATURE_LDREX has a bit per access size of the exclusive monitor: ARMv7-M and
+// ARMv8-M have byte, halfword and word (no M profile core has LDREXD), ARMv6-M none
+template<typename T>
+inline constexpr bool hasExclusive = (__ARM_FEATURE_LDREX & sizeof(T)) != 0;
+#else
+template<typename T>
+inline constexpr bool hasExclusive = false;
+#endif
+
+// values wider than a word are written under the guard and read through atomicSequence
 template<typename T>
-T atomic_load_block(void const volatile* ptr,
-                    [[maybe_unused]] int memorder) {
-    Kvasir::Nvic::InterruptGuard<Kvasir::Nvic::Global> guard;
-    T v = *reinterpret_cast<T const volatile*>(ptr);
+inline constexpr bool useSeqLock = !hasExclusive<T> && sizeof(T) > 4;
+
+template<typename T>
+T load_exclusive(T volatile* ptr) {
+    T v;
+    if constexpr(sizeof(T) == 1) {
+        asm volatile("ldrexb %0, %1" : "=r"(v) : "Q"(*ptr) : "memory");
+    } else if constexpr(sizeof(T) == 2) {
+        asm volatile("ldrexh %0, %1" : "=r"(v) : "Q"(*ptr) : "memory");
+    } else if constexpr(sizeof(T) == 4) {
+        asm volatile("ldrex %0, %1" : "=r"(v) : "Q"(*ptr) : "memory");
+    } else {
+        asm volatile("ldrexd %0, %H0, %1" : "=&r"(v) : "Q"(*ptr) : "memory");
+    }
     return v;
 }
 
+// false if the monitor was lost, e.g. by an exception entry since load_exclusive
 template<typename T>
-void atomic_store_block(void volatile*       ptr,
-                        T                    val,
-                        [[maybe_unused]] int memorder) {
-    Kvasir::Nvic::InterruptGuard<Kvasir::Nvic::Global> guard;
-    *reinterpret_cast<T volatile*>(ptr) = val;
+bool store_exclusive(T volatile* ptr,
+                     T           v) {
+    unsigned failed;
+    if constexpr(sizeof(T) == 1) {
+        asm volatile("strexb %0, %2, %1" : "=&r"(failed), "=Q"(*ptr) : "r"(v) : "memory");
+    } else if constexpr(sizeof(T) == 2) {
+        asm volatile("strexh %0, %2, %1" : "=&r"(failed), "=Q"(*ptr) : "r"(v) : "memory");
+    } else if constexpr(sizeof(T) == 4) {
+        asm volatile("strex %0, %2, %1" : "=&r"(failed), "=Q"(*ptr) : "r"(v) : "memory");
+    } else {
+        asm volatile("strexd %0, %2, %H2, %1" : "=&r"(failed), "=Q"(*ptr) : "r"(v) : "memory");
+    }
+    return failed == 0;
 }
 
+inline void clear_exclusive() { asm volatile("clrex" : : : "memory"); }
+
+// The global guard of the helpers below. The __atomic_* entry points pass their return
+// address as caller, so the profile gets one site per calling function instead of one
+// for all 64 bit and odd sized atomics in the firmware.
+#ifdef KVASIR_PROFILE_CRITICAL_SECTIONS
+[[gnu::always_inline]] inline Kvasir::Nvic::InterruptGuard<Kvasir::Nvic::Global>
+lock(void const*                 caller,
+     std::source_location const& loc = std::source_location::current()) {
+    return Kvasir::Nvic::InterruptGuard<Kvasir::Nvic::Global>{loc, caller};
+}
+#else
+[[gnu::always_inline]] inline Kvasir::Nvic::InterruptGuard<Kvasir::Nvic::Global>
+lock(void const*) {
+    return Kvasir::Nvic::InterruptGuard<Kvasir::Nvic::Global>{};
+}
+#endif
+
+// only call with the global guard held
 template<typename T>
-T atomic_exchange_block(void volatile*       ptr,
-                        T                    val,
-                        [[maybe_unused]] int memorder) {
-    Kvasir::Nvic::InterruptGuard<Kvasir::Nvic::Global> guard;
-    T                                                  old = *reinterpret_cast<T volatile*>(ptr);
-    *reinterpret_cast<T volatile*>(ptr)                    = val;
-    return old;
+void store_locked(T volatile* ptr,
+                  T           val) {
+    if constexpr(useSeqLock<T>) {
+        atomicSequence.write([&]() { *ptr = val; });
+    } else {
+        *ptr = val;
+    }
+}
+
+// stores f(old) and returns old
+template<typename T,
+         typename F>
+T atomic_update(void volatile*               ptr,
+                F&&                          f,
+                [[maybe_unused]] void const* caller) {
+    auto* const p = reinterpret_cast<T volatile*>(ptr);
+    if constexpr(hasExclusive<T>) {
+        T old;
+        do {
+            old = load_exclusive(p);
+        } while(!store_exclusive(p, f(old)));
+        return old;
+    } else {
+        auto const guard = lock(caller);
+        T const    old   = *p;
+        store_locked(p, f(old));
+        return old;
+    }
 }
 
 template<typename T>
-bool atomic_compare_exchange_block(void volatile*        ptr,
-                                   void*                 expected,
-                                   T                     desired,
-                                   [[maybe_unused]] bool weak,
-                                   [[maybe_unused]] int  success_memorder,
-                                   [[maybe_unused]] int  failure_memorder) {
-    Kvasir::Nvic::InterruptGuard<Kvasir::Nvic::Global> guard;
-    bool                                               ret{};
-    if(*reinterpret_cast<T volatile*>(ptr) == *reinterpret_cast<T*>(expected)) {
-        *reinterpret_cast<T volatile*>(ptr) = desired;
-        ret                                 = true;
+T atomic_load(void const volatile* ptr,
+              [[maybe_unused]] int memorder) {
+    auto* const p = reinterpret_cast<T volatile*>(const_cast<void volatile*>(ptr));
+    if constexpr(hasExclusive<T>) {
+        T const v = load_exclusive(p);
+        clear_exclusive();
+        return v;
+    } else if constexpr(useSeqLock<T>) {
+        T v;
+        atomicSequence.read([&]() { v = *p; });
+        return v;
     } else {
-        *reinterpret_cast<T*>(expected) = *reinterpret_cast<T volatile*>(ptr);
-        ret                             = false;
+        return *p;
+    }
+}
+
+template<typename T>
+void atomic_store(void volatile*       ptr,
+                  T                    val,
+                  [[maybe_unused]] int memorder,
+                  void const*          caller) {
+    atomic_update<T>(ptr, [&](T) { return val; }, caller);
+}
+
+template<typename T>
+T atomic_exchange(void volatile*       ptr,
+                  T                    val,
+                  [[maybe_unused]] int memorder,
+                  void const*          caller) {
+    return atomic_update<T>(ptr, [&](T) { return val; }, caller);
+}
+
+template<typename T>
+T atomic_fetch_add(void volatile*       ptr,
+                   T                    val,
+                   [[maybe_unused]] int memorder,
+                   void const*          caller) {
+    return atomic_update<T>(ptr, [&](T old) { return static_cast<T>(old + val); }, caller);
+}
+
+template<typename T>
+bool atomic_compare_exchange(void volatile*               ptr,
+                             void*                        expected,
+                             T                            desired,
+                             [[maybe_unused]] bool        weak,
+                             [[maybe_unused]] int         success_memorder,
+                             [[maybe_unused]] int         failure_memorder,
+                             [[maybe_unused]] void const* caller) {
+    auto* const p = reinterpret_cast<T volatile*>(ptr);
+    auto&       e = *reinterpret_cast<T*>(expected);
+    if constexpr(hasExclusive<T>) {
+        while(true) {
+            T const current = load_exclusive(p);
+            if(current != e) {
+                clear_exclusive();
+                e = current;
+                return false;
+            }
+            if(store_exclusive(p, desired)) { return true; }
+        }
+    } else {
+        auto const guard   = lock(caller);
+        T const    current = *p;
+        if(current == e) {
+            store_locked(p, desired);
+            return true;
+        }
+        e = current;
+        return false;
     }
-    return ret;
 }
 
+// generic (odd sized) atomics, the writers share atomicSequence with the 64 bit ones
 inline void atomic_load_mem_block(std::size_t          size,
                                   void const volatile* src,
                                   void*                dest,
                                   [[maybe_unused]] int memorder) {
-    Kvasir::Nvic::InterruptGuard<Kvasir::Nvic::Global> guard;
-    std::memcpy(dest, const_cast<void const*>(src), size);
+    atomicSequence.read([&]() { std::memcpy(dest, const_cast<void const*>(src), size); });
 }
 
 inline void atomic_store_mem_block(std::size_t          size,
                                    void volatile*       dest,
                                    void const*          src,
-                                   [[maybe_unused]] int memorder) {
-    Kvasir::Nvic::InterruptGuard<Kvasir::Nvic::Global> guard;
-    std::memcpy(const_cast<void*>(dest), src, size);
+                                   [[maybe_unused]] int memorder,
+                                   void const*          caller) {
+    auto const guard = lock(caller);
+    atomicSequence.write([&]() { std::memcpy(const_cast<void*>(dest), src, size); });
 }
 
 inline void atomic_exchange_mem_block(std::size_t          size,
                                       void volatile*       ptr,
                                       void const*          val,
                                       void*                ret,
-                                      [[maybe_unused]] int memorder) {
-    Kvasir::Nvic::InterruptGuard<Kvasir::Nvic::Global> guard;
+                                      [[maybe_unused]] int memorder,
+                                      void const*          caller) {
+    auto const guard = lock(caller);
     std::memcpy(ret, const_cast<void const*>(ptr), size);
-    std::memcpy(const_cast<void*>(ptr), val, size);
+    atomicSequence.write([&]() { std::memcpy(const_cast<void*>(ptr), val, size); });
 }
 
 inline bool atomic_compare_exchange_mem_block(std::size_t           size,
@@ -196,11 +370,12 @@ inline bool atomic_compare_exchange_mem_block(std::size_t           size,
                                               void const*           desired,
                                               [[maybe_unused]] bool weak,
                                               [[maybe_unused]] int  success_memorder,
-                                              [[maybe_unused]] int  failure_memorder) {
-    Kvasir::Nvic::InterruptGuard<Kvasir::Nvic::Global> guard;
-    bool                                               ret{};
+                                              [[maybe_unused]] int  failure_memorder,
+                                              void const*           caller) {
+    auto const guard = lock(caller);
+    bool       ret{};
     if(std::memcmp(const_cast<void const*>(ptr), expected, size) == 0) {
-        std::memcpy(const_cast<void*>(ptr), desired, size);
+        atomicSequence.write([&]() { std::memcpy(const_cast<void*>(ptr), desired, size); });
         ret = true;
     } else {
         std::memcpy(expected, const_cast<void const*>(ptr), size);
@@ -214,37 +389,49 @@ inline bool atomic_compare_exchange_mem_block(std::size_t           size,
 extern "C" {
 [[gnu::used]] inline unsigned long long __atomic_load_8(void const volatile* ptr,
                                                         int                  memorder) {
-    return CommonAtomic::atomic_load_block<unsigned long long>(ptr, memorder);
+    return CommonAtomic::atomic_load<unsigned long long>(ptr, memorder);
 }
 
 [[gnu::used]] inline void __atomic_store_8(void volatile*     ptr,
                                            unsigned long long val,
                                            int                memorder) {
-    CommonAtomic::atomic_store_block<unsigned long long>(ptr, val, memorder);
+    CommonAtomic::atomic_store<unsigned long long>(ptr, val, memorder, __builtin_return_address(0));
 }
 
 [[gnu::used]] inline unsigned char __atomic_exchange_1(void volatile* ptr,
                                                        unsigned char  val,
                                                        int            memorder) {
-    return CommonAtomic::atomic_exchange_block<unsigned char>(ptr, val, memorder);
+    return CommonAtomic::atomic_exchange<unsigned char>(ptr,
+                                                        val,
+                                                        memorder,
+                                                        __builtin_return_address(0));
 }
 
 [[gnu::used]] inline unsigned short __atomic_exchange_2(void volatile* ptr,
                                                         unsigned short val,
                                                         int            memorder) {
-    return CommonAtomic::atomic_exchange_block<unsigned short>(ptr, val, memorder);
+    return CommonAtomic::atomic_exchange<unsigned short>(ptr,
+                                                         val,
+                                                         memorder,
+                                                         __builtin_return_address(0));
 }
 
 [[gnu::used]] inline unsigned __atomic_exchange_4(void volatile* ptr,
                                                   unsigned       val,
                                                   int            memorder) {
-    return CommonAtomic::atomic_exchange_block<unsigned>(ptr, val, memorder);
+    return CommonAtomic::atomic_exchange<unsigned>(ptr,
+                                                   val,
+                                                   memorder,
+                                                   __builtin_return_address(0));
 }
 
 [[gnu::used]] inline unsigned long long __atomic_exchange_8(void volatile*     ptr,
                                                             unsigned long long val,
                                                             int                memorder) {
-    return CommonAtomic::atomic_exchange_block<unsigned long long>(ptr, val, memorder);
+    return CommonAtomic::atomic_exchange<unsigned long long>(ptr,
+                                                             val,
+                                                             memorder,
+                                                             __builtin_return_address(0));
 }
 
 [[gnu::used]] inline bool __atomic_compare_exchange_1(void volatile* ptr,
@@ -253,12 +440,13 @@ extern "C" {
                                                       bool           weak,
                                                       int            success_memorder,
                                                       int            failure_memorder) {
-    return CommonAtomic::atomic_compare_exchange_block<unsigned char>(ptr,
-                                                                      expected,
-                                                                      desired,
-                                                                      weak,
-                                                                      success_memorder,
-                                                                      failure_memorder);
+    return CommonAtomic::atomic_compare_exchange<unsigned char>(ptr,
+                                                                expected,
+                                                                desired,
+                                                                weak,
+                                                                success_memorder,
+                                                                failure_memorder,
+                                                                __builtin_return_address(0));
 }
 
 [[gnu::used]] inline bool __atomic_compare_exchange_2(void volatile* ptr,
@@ -267,12 +455,13 @@ extern "C" {
                                                       bool           weak,
                                                       int            success_memorder,
                                                       int            failure_memorder) {
-    return CommonAtomic::atomic_compare_exchange_block<unsigned short>(ptr,
-                                                                       expected,
-                                                                       desired,
-                                                                       weak,
-                                                                       success_memorder,
-                                                                       failure_memorder);
+    return CommonAtomic::atomic_compare_exchange<unsigned short>(ptr,
+                                                                 expected,
+                                                                 desired,
+                                                                 weak,
+                                                                 success_memorder,
+                                                                 failure_memorder,
+                                                                 __builtin_return_address(0));
 }
 
 [[gnu::used]] inline bool __atomic_compare_exchange_4(void volatile* ptr,
@@ -281,12 +470,13 @@ extern "C" {
                                                       bool           weak,
                                                       int            success_memorder,
                                                       int            failure_memorder) {
-    return CommonAtomic::atomic_compare_exchange_block<unsigned>(ptr,
-                                                                 expected,
-                                                                 desired,
-                                                                 weak,
-                                                                 success_memorder,
-                                                                 failure_memorder);
+    return CommonAtomic::atomic_compare_exchange<unsigned>(ptr,
+                                                           expected,
+                                                           desired,
+                                                           weak,
+                                                           success_memorder,
+                                                           failure_memorder,
+                                                           __builtin_return_address(0));
 }
 
 [[gnu::used]] inline bool __atomic_compare_exchange_8(void volatile*     ptr,
@@ -295,21 +485,21 @@ extern "C" {
                                                       bool               weak,
                                                       int                success_memorder,
                                                       int                failure_memorder) {
-    return CommonAtomic::atomic_compare_exchange_block<unsigned long long>(ptr,
-                                                                           expected,
-                                                                           desired,
-                                                                           weak,
-                                                                           success_memorder,
-                                                                           failure_memorder);
+    return CommonAtomic::atomic_compare_exchange<unsigned long long>(ptr,
+                                                                     expected,
+                                                                     desired,
+                                                                     weak,
+                                                                     success_memorder,
+                                                                     failure_memorder,
+                                                                     __builtin_return_address(0));
 }
 
-[[gnu::used]] inline unsigned long long __atomic_fetch_add_8(void volatile*       ptr,
-                                                             unsigned long long   val,
-                                                             [[maybe_unused]] int memorder) {
-    Kvasir::Nvic::InterruptGuard<Kvasir::Nvic::Global> guard;
-    auto&                    ref = *reinterpret_cast<unsigned long long volatile*>(ptr);
-    unsigned long long const old = ref;
-    ref                          = old + val;
-    return old;
+[[gnu::used]] inline unsigned long long __atomic_fetch_add_8(void volatile*     ptr,
+                                                             unsigned long long val,
+                                                             int                memorder) {
+    return CommonAtomic::atomic_fetch_add<unsigned long long>(ptr,
+                                                              val,
+                                                              memorder,
+                                                              __builtin_return_address(0));
 }
 }
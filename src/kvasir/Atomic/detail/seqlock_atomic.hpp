@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace CommonAtomic {
+
+// Sequence lock for the atomics the core cannot access with a single instruction
+// (64 bit and larger without LDREXD). Writers hold a lock (the global InterruptGuard
+// on Cortex-M) and keep the sequence odd while they write; readers take no lock and
+// retry if the sequence was odd or changed during the read, so loads of 64 bit
+// timestamps and counters do not mask interrupts.
+//
+// A reader that preempts a writer (NMI, HardFault) would retry forever, such handlers
+// must not read a value the interrupted code may be writing.
+struct SeqLock {
+    std::atomic<std::uint32_t> sequence{};
+
+    static void fence() noexcept {
+#ifdef __arm__
+        // single core with the writer masked, only the compiler may reorder
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+#else
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+#endif
+    }
+
+    template<typename F>
+    void read(F&& f) const noexcept {
+        while(true) {
+            std::uint32_t const s = sequence.load(std::memory_order_relaxed);
+            fence();
+            if((s & 1U) == 0) {
+                f();
+                fence();
+                if(sequence.load(std::memory_order_relaxed) == s) { return; }
+            }
+        }
+    }
+
+    // only call with the writer lock held
+    template<typename F>
+    void write(F&& f) noexcept {
+        std::uint32_t const s = sequence.load(std::memory_order_relaxed);
+        sequence.store(s + 1, std::memory_order_relaxed);
+        fence();
+        f();
+        fence();
+        sequence.store(s + 2, std::memory_order_relaxed);
+    }
+};
+
+// one sequence for all wide atomics: a write only makes concurrent readers retry
+inline SeqLock atomicSequence{};
+
+}   // namespace CommonAtomic
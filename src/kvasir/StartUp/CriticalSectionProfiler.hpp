@@ -0,0 +1,97 @@
+#pragma once
+
+#include "kvasir/StartUp/TimeSource.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <source_location>
+#include <string_view>
+
+// Number of distinct InterruptGuard call sites that can be tracked, further sites
+// are counted in CriticalSectionTable::dropped.
+#ifndef KVASIR_CRITICAL_SECTION_SITES
+    #define KVASIR_CRITICAL_SECTION_SITES 32
+#endif
+
+namespace Kvasir { namespace Startup {
+
+    // Masked time statistics of one InterruptGuard call site; file = nullptr marks an
+    // unused slot. caller tells apart the sites of one shared guard, e.g. the return
+    // address of the __atomic_* runtime functions (resolve with addr2line).
+    struct CriticalSectionSite {
+        char const*   file;
+        char const*   function;
+        void const*   caller;
+        std::uint32_t line;
+        std::uint32_t column;
+        std::uint32_t count;
+        std::uint32_t maxCycles;
+        std::uint64_t totalCycles;
+
+        std::array<std::uint32_t, profileHistogramBuckets> histogram;
+
+        std::uint32_t average() const noexcept {
+            return count == 0 ? 0 : static_cast<std::uint32_t>(totalCycles / count);
+        }
+    };
+
+    // Call site keyed statistics of critical sections, filled by the instrumented
+    // Nvic::InterruptGuard<Global> (KVASIR_PROFILE_CRITICAL_SECTIONS). record() runs
+    // with interrupts masked, so the fields are plain integers; readers copy a site
+    // under an InterruptGuard.
+    template<std::size_t Sites>
+    struct CriticalSectionTable {
+        static_assert(Sites >= 1 && (Sites & (Sites - 1)) == 0,
+                      "Sites must be a power of two");
+
+        std::uint32_t                          dropped;   // sections of untracked sites
+        std::array<CriticalSectionSite, Sites> sites;
+
+        // open addressing with linear probing on (file, line, column, caller); only call
+        // with interrupts masked
+        void record(std::source_location const& loc,
+                    std::uint32_t               cycles,
+                    void const*                 caller = nullptr) noexcept {
+            auto const  c = static_cast<std::size_t>(reinterpret_cast<std::uintptr_t>(caller) >> 1);
+            std::size_t i = (loc.line() * 31U + loc.column() + c) & (Sites - 1);
+            for(std::size_t probe = 0; probe < Sites; ++probe) {
+                auto& s = sites[i];
+                if(s.file == nullptr) {
+                    s.file     = loc.file_name();
+                    s.function = loc.function_name();
+                    s.caller   = caller;
+                    s.line     = loc.line();
+                    s.column   = loc.column();
+                }
+                if(s.line == loc.line() && s.column == loc.column() && s.caller == caller
+                   && sameFile(s.file, loc))
+                {
+                    ++s.count;
+                    s.totalCycles += cycles;
+                    if(cycles > s.maxCycles) { s.maxCycles = cycles; }
+                    ++s.histogram[static_cast<std::size_t>(std::bit_width(cycles))];
+                    return;
+                }
+                i = (i + 1) & (Sites - 1);
+            }
+            ++dropped;
+        }
+
+        void clear() noexcept {
+            dropped = 0;
+            sites   = {};
+        }
+
+    private:
+        // the same file name may be a different string in every translation unit
+        static bool sameFile(char const*                 file,
+                             std::source_location const& loc) noexcept {
+            return file == loc.file_name() || std::string_view{file} == loc.file_name();
+        }
+    };
+
+    inline CriticalSectionTable<KVASIR_CRITICAL_SECTION_SITES> criticalSections{};
+
+}}   // namespace Kvasir::Startup
@@ -1,14 +1,53 @@
 #pragma once
 
 #include "kvasir/Common/Interrupt.hpp"
+#include "kvasir/Io/Io.hpp"
+#include "kvasir/Register/Register.hpp"
+#include "kvasir/StartUp/IsrTrace.hpp"
+#include "kvasir/StartUp/TimeSource.hpp"
 
+#include <algorithm>
 #include <array>
 #include <atomic>
+#include <bit>
+#include <cstddef>
 #include <cstdint>
 #include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#ifdef __arm__
+    #include "kvasir/Atomic/Atomic.hpp"
+#endif
 
 namespace Kvasir { namespace Startup {
 
+    namespace Detail {
+        // lock-free running minimum / maximum, relaxed because the values are only statistics
+        template<typename T>
+        void atomicMin(std::atomic<T>& target,
+                       T               value) noexcept {
+            T old = target.load(std::memory_order_relaxed);
+            while(value < old
+                  && !target.compare_exchange_weak(old, value, std::memory_order_relaxed))
+            {}
+        }
+
+        // returns true if value became the new maximum
+        template<typename T>
+        bool atomicMax(std::atomic<T>& target,
+                       T               value) noexcept {
+            T old = target.load(std::memory_order_relaxed);
+            while(value > old) {
+                if(target.compare_exchange_weak(old, value, std::memory_order_relaxed)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }   // namespace Detail
+
     // Snapshot of statistics for one ISR at a point in time
     struct IsrProfileSnapshot {
         int           isrIndex;
@@ -20,110 +59,228 @@ namespace Kvasir { namespace Startup {
         std::uint32_t minDurationCycles;
         std::uint32_t maxDurationCycles;
         std::uint32_t avgDurationCycles;
+        std::uint32_t latencyCount;   // 0 if no eventTime() hook is configured for this ISR
+        std::uint32_t minLatencyCycles;
+        std::uint32_t maxLatencyCycles;
+        std::uint32_t avgLatencyCycles;
+        std::uint32_t deadlineViolations;   // 0 if no DeadlineBudget is configured for this ISR
+        std::uint32_t worstOverrunCycles;   // duration minus budget of the worst violation
+        std::uint32_t worstOverrunTime;     // TimeSource entry timestamp of the worst violation
+    };
+
+    // Statistics engine shared by the ISR and scope profilers: count, min, max and
+    // total of a cycle count, optionally with a log2 histogram. Lock-free, so it may
+    // be updated from any ISR; the fields are only statistics and use relaxed order.
+    template<bool WithHistogram = false>
+    struct ProfileStats {
+        std::atomic<std::uint32_t> count{0};
+        std::atomic<std::uint32_t> min{std::numeric_limits<std::uint32_t>::max()};
+        std::atomic<std::uint32_t> max{0};
+        std::atomic<std::uint64_t> total{0};
+        std::conditional_t<WithHistogram,
+                           std::array<std::atomic<std::uint32_t>, profileHistogramBuckets>,
+                           std::array<std::atomic<std::uint32_t>, 0>>
+          histogram{};
+
+        void record(std::uint32_t cycles) noexcept {
+            count.fetch_add(1, std::memory_order_relaxed);
+            Detail::atomicMin(min, cycles);
+            Detail::atomicMax(max, cycles);
+            total.fetch_add(cycles, std::memory_order_relaxed);
+            if constexpr(WithHistogram) {
+                histogram[static_cast<std::size_t>(std::bit_width(cycles))].fetch_add(
+                  1,
+                  std::memory_order_relaxed);
+            }
+        }
+
+        std::uint32_t average() const noexcept {
+            auto const n = count.load(std::memory_order_relaxed);
+            return n > 0 ? static_cast<std::uint32_t>(total.load(std::memory_order_relaxed) / n)
+                         : 0;
+        }
+
+        std::uint32_t minimum() const noexcept { return min.load(std::memory_order_relaxed); }
+
+        std::uint32_t maximum() const noexcept { return max.load(std::memory_order_relaxed); }
     };
 
     // Per-ISR statistics storage, unique per <IsrIndex, TimeSource>
     template<int IsrIndex, typename TimeSource>
     struct IsrProfileStats {
-        // --- interval tracking (time between consecutive ISR entries) ---
         static inline std::atomic<bool>          hasFirst{false};
-        static inline std::atomic<std::uint32_t> callCount{0};
         static inline std::atomic<std::uint32_t> lastCallTime{0};
-        static inline std::atomic<std::uint32_t> minInterval{
-          std::numeric_limits<std::uint32_t>::max()};
-        static inline std::atomic<std::uint32_t> maxInterval{0};
-        static inline std::atomic<std::uint64_t> totalInterval{0};
-
-        // --- duration tracking (time spent inside the ISR) ---
-        static inline std::atomic<std::uint32_t> minDuration{
-          std::numeric_limits<std::uint32_t>::max()};
-        static inline std::atomic<std::uint32_t> maxDuration{0};
-        static inline std::atomic<std::uint64_t> totalDuration{0};
-
-        // Called from IsrProfileWrapper: enter = DWT before Original(),
-        //                                exit  = DWT after Original().
+
+        // time between consecutive ISR entries
+        static inline ProfileStats<> interval{};
+        // time spent inside the ISR, count is the number of calls
+        static inline ProfileStats<true> duration{};
+        // time from the event to ISR entry, see LatencyPolicy
+        static inline ProfileStats<> latency{};
+
+        // durations over the DeadlineBudget of this ISR, see DeadlinePolicy
+        static inline std::atomic<std::uint32_t> deadlineViolations{0};
+        static inline std::atomic<std::uint32_t> worstOverrun{0};
+        static inline std::atomic<std::uint32_t> worstOverrunTime{0};
+
+        // Called from IsrProfileWrapper: enter = TimeSource before Original(),
+        //                                exit  = TimeSource after Original().
         static void record(std::uint32_t enter,
                            std::uint32_t exit) noexcept {
             // Interval between consecutive ISR entries.
             // hasFirst guards against the CYCCNT=0 wraparound false-positive
             // that the old `last != 0` check suffered from.
             std::uint32_t const last = lastCallTime.exchange(enter, std::memory_order_relaxed);
-            callCount.fetch_add(1, std::memory_order_relaxed);
             if(hasFirst.load(std::memory_order_relaxed)) {
-                std::uint32_t const interval = enter - last;
-                std::uint32_t       old      = minInterval.load(std::memory_order_relaxed);
-                while(
-                  interval < old
-                  && !minInterval.compare_exchange_weak(old, interval, std::memory_order_relaxed))
-                {}
-                old = maxInterval.load(std::memory_order_relaxed);
-                while(
-                  interval > old
-                  && !maxInterval.compare_exchange_weak(old, interval, std::memory_order_relaxed))
-                {}
-                totalInterval.fetch_add(interval, std::memory_order_relaxed);
+                interval.record(enter - last);
             } else {
                 hasFirst.store(true, std::memory_order_relaxed);
             }
 
             // Duration of this ISR invocation.
-            std::uint32_t const duration = exit - enter;
-            std::uint32_t       old      = minDuration.load(std::memory_order_relaxed);
-            while(duration < old
-                  && !minDuration.compare_exchange_weak(old, duration, std::memory_order_relaxed))
-            {}
-            old = maxDuration.load(std::memory_order_relaxed);
-            while(duration > old
-                  && !maxDuration.compare_exchange_weak(old, duration, std::memory_order_relaxed))
-            {}
-            totalDuration.fetch_add(duration, std::memory_order_relaxed);
+            duration.record(exit - enter);
+        }
+
+        // Called from IsrProfileWrapper with entry time minus eventTime() when the
+        // policy provides an event time hook for this ISR.
+        static void recordLatency(std::uint32_t cycles) noexcept { latency.record(cycles); }
+
+        // Called from IsrProfileWrapper when duration exceeded the budget. The time of
+        // the worst overrun is stored after the overrun itself, a concurrent worse
+        // violation from a nested ISR may briefly pair with the older timestamp.
+        static void recordDeadlineViolation(std::uint32_t enter,
+                                            std::uint32_t overrun) noexcept {
+            deadlineViolations.fetch_add(1, std::memory_order_relaxed);
+            if(Detail::atomicMax(worstOverrun, overrun)) {
+                worstOverrunTime.store(enter, std::memory_order_relaxed);
+            }
         }
 
         static IsrProfileSnapshot snapshot() noexcept {
-            auto const count     = callCount.load(std::memory_order_relaxed);
-            auto const intvTotal = totalInterval.load(std::memory_order_relaxed);
-            auto const durTotal  = totalDuration.load(std::memory_order_relaxed);
-            // Interval avg uses (count - 1) because N calls produce N-1 intervals
-            auto const intvCount = count > 1 ? count - 1 : 0;
             return {IsrIndex,
-                    count,
-                    minInterval.load(std::memory_order_relaxed),
-                    maxInterval.load(std::memory_order_relaxed),
-                    intvCount > 0 ? static_cast<std::uint32_t>(intvTotal / intvCount) : 0,
+                    duration.count.load(std::memory_order_relaxed),
+                    interval.minimum(),
+                    interval.maximum(),
+                    interval.average(),
                     lastCallTime.load(std::memory_order_relaxed),
-                    minDuration.load(std::memory_order_relaxed),
-                    maxDuration.load(std::memory_order_relaxed),
-                    count > 0 ? static_cast<std::uint32_t>(durTotal / count) : 0};
+                    duration.minimum(),
+                    duration.maximum(),
+                    duration.average(),
+                    latency.count.load(std::memory_order_relaxed),
+                    latency.minimum(),
+                    latency.maximum(),
+                    latency.average(),
+                    deadlineViolations.load(std::memory_order_relaxed),
+                    worstOverrun.load(std::memory_order_relaxed),
+                    worstOverrunTime.load(std::memory_order_relaxed)};
         }
     };
 
-    // Default time source: ARM DWT cycle counter (Cortex-M3/M4/M7/M33)
-    struct DwtTimeSource {
-        static std::uint32_t now() noexcept {
-            return *reinterpret_cast<std::uint32_t const volatile*>(0xE0001004U);   // DWT_CYCCNT
-        }
+    struct ProfileAllPolicy;
 
-        // Must be called once before any ISR fires (before Nvic::enable_all)
-        static void enable() noexcept {
-            // Enable trace subsystem: CoreDebug->DEMCR TRCENA bit
-            *reinterpret_cast<std::uint32_t volatile*>(0xE000EDFC) |= (1U << 24);
-            // Reset and enable cycle counter: DWT_CTRL CYCCNTENA bit
-            *reinterpret_cast<std::uint32_t volatile*>(0xE0001004) = 0;   // reset CYCCNT
-            *reinterpret_cast<std::uint32_t volatile*>(0xE0001000) |= 1U;
-        }
-    };
+    namespace Detail {
+        // first T in Ts with T::index == I, its ::type is the result; Default if none matches
+        template<int I, typename Default, typename... Ts>
+        struct FindByIndex {
+            using type = Default;
+        };
+
+        template<int I, typename Default, typename T, typename... Ts>
+        struct FindByIndex<I, Default, T, Ts...>
+          : std::conditional_t<T::index == I, T, FindByIndex<I, Default, Ts...>> {};
 
-    // Unique wrapper type per (OriginalFn, InterruptIndex, TimeSource).
+        template<int I, typename Default, typename... Ts>
+        using FindByIndexT = typename FindByIndex<I, Default, Ts...>::type;
+
+        // the eventTime() hook of Policy for ISR I, void if the policy has none
+        template<typename Policy, int I>
+        struct GetEventTime {
+            using type = void;
+        };
+
+        template<typename Policy, int I>
+            requires requires { typename Policy::template EventTime<I>; }
+        struct GetEventTime<Policy, I> {
+            using type = typename Policy::template EventTime<I>;
+        };
+
+        template<typename Policy, int I>
+        using GetEventTimeT = typename GetEventTime<Policy, I>::type;
+
+        template<typename Policy>
+        constexpr bool tracesEvents = requires { requires Policy::traceEvents; };
+
+        // the DeadlineBudget of Policy for ISR I, void if the policy has none
+        template<typename Policy, int I>
+        struct GetDeadline {
+            using type = void;
+        };
+
+        template<typename Policy, int I>
+            requires requires { typename Policy::template Deadline<I>; }
+        struct GetDeadline<Policy, I> {
+            using type = typename Policy::template Deadline<I>;
+        };
+
+        template<typename Policy, int I>
+        using GetDeadlineT = typename GetDeadline<Policy, I>::type;
+
+        // the pin marker of Policy for ISR I, void if the policy has none
+        template<typename Policy, int I>
+        struct GetPinMarker {
+            using type = void;
+        };
+
+        template<typename Policy, int I>
+            requires requires { typename Policy::template PinMarker<I>; }
+        struct GetPinMarker<Policy, I> {
+            using type = typename Policy::template PinMarker<I>;
+        };
+
+        template<typename Policy, int I>
+        using GetPinMarkerT = typename GetPinMarker<Policy, I>::type;
+    }   // namespace Detail
+
+    // Unique wrapper type per (OriginalFn, InterruptIndex, TimeSource, Policy).
     // Exposes `value` and `IType` identical to Nvic::Isr<F, Index<I>>
     // so CompileIsrPointerList's lookup works unchanged.
     template<Nvic::IsrFunctionPointer Original,
              typename IndexType,
-             typename TimeSource = DwtTimeSource>
+             typename TimeSource = DwtTimeSource,
+             typename Policy     = ProfileAllPolicy>
     struct IsrProfileWrapper {
+        using Stats     = IsrProfileStats<IndexType::value, TimeSource>;
+        using EventTime = Detail::GetEventTimeT<Policy, IndexType::value>;
+        using Deadline  = Detail::GetDeadlineT<Policy, IndexType::value>;
+        using PinMarker = Detail::GetPinMarkerT<Policy, IndexType::value>;
+
         static void onIsr() noexcept {
+            // the pins enclose the measured region so the statistics do not include them
+            if constexpr(!std::is_void_v<PinMarker>) { PinMarker::enter(); }
             std::uint32_t const enter = TimeSource::now();
+            std::uint32_t       latency{};
+            if constexpr(!std::is_void_v<EventTime>) {
+                // read the event time before Original() can re-arm the capture
+                latency = enter - EventTime::eventTime();
+            }
             Original();
-            IsrProfileStats<IndexType::value, TimeSource>::record(enter, TimeSource::now());
+            std::uint32_t const exit = TimeSource::now();
+            Stats::record(enter, exit);
+            if constexpr(!std::is_void_v<EventTime>) { Stats::recordLatency(latency); }
+            if constexpr(!std::is_void_v<Deadline>) {
+                std::uint32_t const duration = exit - enter;
+                if(duration > Deadline::budget) {
+                    Stats::recordDeadlineViolation(enter, duration - Deadline::budget);
+                    Policy::Monitor::post(IndexType::value, enter, duration, Deadline::budget);
+                }
+            }
+            if constexpr(Detail::tracesEvents<Policy>) {
+                isrTraceBuffer.add(IsrTraceKind::isr,
+                                   static_cast<std::int16_t>(IndexType::value),
+                                   enter,
+                                   exit);
+            }
+            if constexpr(!std::is_void_v<PinMarker>) { PinMarker::exit(); }
         }
 
         static constexpr Nvic::IsrFunctionPointer value = &onIsr;
@@ -135,8 +292,8 @@ namespace Kvasir { namespace Startup {
     template<typename T>
     struct IsProfileWrapper : std::false_type {};
 
-    template<Nvic::IsrFunctionPointer F, typename I, typename TS>
-    struct IsProfileWrapper<IsrProfileWrapper<F, I, TS>> : std::true_type {};
+    template<Nvic::IsrFunctionPointer F, typename I, typename TS, typename P>
+    struct IsProfileWrapper<IsrProfileWrapper<F, I, TS, P>> : std::true_type {};
 
     // -------------------------------------------------------------------
     // Policy types — control which ISR indices get wrapped
@@ -169,6 +326,187 @@ namespace Kvasir { namespace Startup {
           : std::bool_constant<((std::remove_cv_t<decltype(Interrupts)>::value != I) && ...)> {};
     };
 
+    // Interrupt-to-entry latency source for one interrupt. EventTime::eventTime() must
+    // return the TimeSource timestamp at which the interrupt event happened, e.g. a
+    // timer capture register converted to TimeSource units:
+    //   struct Tim1Capture {
+    //       static std::uint32_t eventTime() noexcept { return ...; }
+    //   };
+    //   LatencySource<Kvasir::Interrupt::tim1_cc, Tim1Capture>
+    template<auto Interrupt, typename EventTimeHook>
+    struct LatencySource {
+        static constexpr int index = std::remove_cv_t<decltype(Interrupt)>::value;
+        using type                 = EventTimeHook;
+    };
+
+    // Adds latency measurement (ISR entry minus event time) to the interrupts of the
+    // given LatencySources; which ISRs are profiled is still decided by BasePolicy:
+    //   LatencyPolicy<ProfileAllPolicy, LatencySource<Kvasir::Interrupt::tim1_cc, Tim1Capture>>
+    template<typename BasePolicy, typename... LatencySources>
+    struct LatencyPolicy : BasePolicy {
+        template<int I>
+            requires(!std::is_void_v<Detail::FindByIndexT<I, void, LatencySources...>>)
+        using EventTime = Detail::FindByIndexT<I, void, LatencySources...>;
+    };
+
+    // Cycle budget of one interrupt, e.g. 8 us at 168 MHz:
+    //   DeadlineBudget<Kvasir::Interrupt::tim1_up, 1344>
+    template<auto Interrupt, std::uint32_t Cycles>
+    struct DeadlineBudget {
+        static constexpr int           index  = std::remove_cv_t<decltype(Interrupt)>::value;
+        static constexpr std::uint32_t budget = Cycles;
+        using type                            = DeadlineBudget;
+    };
+
+    struct DeadlineViolation {
+        int           isrIndex;
+        std::uint32_t enter;      // TimeSource timestamp of the ISR entry
+        std::uint32_t duration;   // cycles spent in the ISR
+        std::uint32_t budget;
+        std::uint32_t missed;     // violations since the previous hook call, >= 1
+    };
+
+    // Forwards deadline violations to Hook::onDeadlineMiss(DeadlineViolation const&)
+    // outside of the violating ISR. The wrapper only stores the violation and pends
+    // PendSV; the hook runs from the PendSV handler, so give PendSV the lowest
+    // priority and add the monitor to the peripheral list of the Startup to install
+    // its Isr. If several violations happen before PendSV runs, the hook sees the
+    // latest one and how many were missed. PendSvInterrupt is the PendSV index of
+    // the chip (-2 in the usual numbering). On the host the hook is called directly.
+    template<typename Hook, auto PendSvInterrupt = Nvic::Index<-2>{}>
+    struct DeadlineMonitor {
+        static void post(int           isrIndex,
+                         std::uint32_t enter,
+                         std::uint32_t duration,
+                         std::uint32_t budget) noexcept {
+#ifdef __arm__
+            {
+                // violations of nested ISRs may race, only the violation path pays for this
+                Nvic::InterruptGuard<Nvic::Global> guard{};
+                latest = {isrIndex, enter, duration, budget, latest.missed + 1};
+            }
+            // SCB_ICSR PENDSVSET
+            *reinterpret_cast<std::uint32_t volatile*>(0xE000ED04) = 1U << 28;
+#else
+            Hook::onDeadlineMiss(DeadlineViolation{isrIndex, enter, duration, budget, 1});
+#endif
+        }
+
+        static void onIsr() noexcept {
+            DeadlineViolation v{};
+            {
+#ifdef __arm__
+                Nvic::InterruptGuard<Nvic::Global> guard{};
+#endif
+                v             = latest;
+                latest.missed = 0;
+            }
+            if(v.missed != 0) { Hook::onDeadlineMiss(v); }
+        }
+
+        using Isr = brigand::list<
+          Nvic::Isr<std::addressof(onIsr),
+                    Nvic::Index<std::remove_cv_t<decltype(PendSvInterrupt)>::value>>>;
+
+    private:
+        static inline DeadlineViolation latest{};
+    };
+
+    // Adds deadline checks to the interrupts of the given DeadlineBudgets; which ISRs
+    // are profiled is still decided by BasePolicy. Violations are counted in the
+    // snapshot and forwarded to Hook through DeadlineMonitor<Hook>:
+    //   using Deadlines = DeadlinePolicy<ProfileAllPolicy,
+    //                                    MissHandler,
+    //                                    DeadlineBudget<Kvasir::Interrupt::tim1_up, 1344>>;
+    //   using Base      = Kvasir::Startup::Startup<Clock, ..., Deadlines::Monitor>;
+    //   using Startup   = StartupWithProfiling<Base, Deadlines>;
+    template<typename BasePolicy, typename Hook, typename... Budgets>
+    struct DeadlinePolicy : BasePolicy {
+        using Monitor = DeadlineMonitor<Hook>;
+
+        template<int I>
+            requires(!std::is_void_v<Detail::FindByIndexT<I, void, Budgets...>>)
+        using Deadline = Detail::FindByIndexT<I, void, Budgets...>;
+    };
+
+    // Event mode: every ISR profiled by BasePolicy additionally writes an
+    // (index, enter, exit) record into isrTraceBuffer, see IsrTrace.hpp.
+    template<typename BasePolicy>
+    struct TraceEventsPolicy : BasePolicy {
+        static constexpr bool traceEvents = true;
+    };
+
+    // Output pins driven by PinMarkerPolicy, given as PinLocations:
+    //   MarkerPins<makePinLocation(Io::port1, Io::pin4), makePinLocation(Io::port1, Io::pin5)>
+    // The pins have to be configured as outputs (initially low) by the application.
+    template<auto... Pins>
+    struct MarkerPins {
+        static constexpr std::size_t count = sizeof...(Pins);
+    };
+
+    namespace Detail {
+        template<unsigned Code, typename Pins>
+        struct PinMarker;
+
+        // pin k shows bit k of Code; on entry all pins are written (set for 1, clear
+        // for 0) in one apply, so nested ISRs show their own code; on exit all pins
+        // are cleared, an interrupted ISR shows 0 until it returns
+        template<unsigned Code, auto... Pins>
+        struct PinMarker<Code, MarkerPins<Pins...>> {
+            static_assert(sizeof...(Pins) > 0 && sizeof...(Pins) <= 16,
+                          "need 1 to 16 marker pins");
+
+            [[gnu::always_inline]] static void enter() noexcept {
+                enterImpl(std::make_index_sequence<sizeof...(Pins)>{});
+            }
+
+            [[gnu::always_inline]] static void exit() noexcept {
+                Register::apply(Register::clear(Pins)...);
+            }
+
+        private:
+            template<std::size_t... Is>
+            [[gnu::always_inline]] static void enterImpl(std::index_sequence<Is...>) noexcept {
+                Register::apply(std::conditional_t<((Code >> Is) & 1U) != 0,
+                                                   decltype(Register::set(Pins)),
+                                                   decltype(Register::clear(Pins))>{}...);
+            }
+        };
+
+        // 1 based position of I in Interrupts, 0 if absent
+        template<int I, auto... Interrupts>
+        constexpr unsigned markerCode() {
+            unsigned code{};
+            unsigned position{};
+            ((++position,
+              code = (code == 0 && std::remove_cv_t<decltype(Interrupts)>::value == I) ? position
+                                                                                      : code),
+             ...);
+            return code;
+        }
+    }   // namespace Detail
+
+    // Logic analyzer markers: every ISR profiled by BasePolicy drives Pins while it
+    // runs, using the chip's Io set/clear actions (single writes to the set/reset
+    // register on chips that have one, no read-modify-write). Without Interrupts all
+    // pins go high for every ISR. With Interrupts only those are marked and the pins
+    // show the 1 based position of the ISR in the list as a binary number:
+    //   PinMarkerPolicy<ProfileAllPolicy, MarkerPins<pin0, pin1>, Interrupt::uart0, Interrupt::tim2>
+    // marks uart0 as 0b01 and tim2 as 0b10. Combines with the other policies, e.g.
+    // LatencyPolicy<PinMarkerPolicy<...>, ...>.
+    template<typename BasePolicy, typename Pins, auto... Interrupts>
+    struct PinMarkerPolicy : BasePolicy {
+        static_assert(sizeof...(Interrupts) < (1ULL << Pins::count),
+                      "not enough marker pins to encode all interrupts");
+
+        template<int I>
+            requires(sizeof...(Interrupts) == 0 || Detail::markerCode<I, Interrupts...>() != 0)
+        using PinMarker
+          = Detail::PinMarker<sizeof...(Interrupts) == 0 ? (1U << Pins::count) - 1U
+                                                         : Detail::markerCode<I, Interrupts...>(),
+                              Pins>;
+    };
+
     // -------------------------------------------------------------------
     // ISR list transformation
     // -------------------------------------------------------------------
@@ -183,7 +521,7 @@ namespace Kvasir { namespace Startup {
     template<typename Policy, typename TimeSource, Nvic::IsrFunctionPointer F, int I>
     struct ApplyProfilingToIsr<Policy, TimeSource, Nvic::Isr<F, Nvic::Index<I>>> {
         using type = std::conditional_t<Policy::template ShouldProfile<I>::value,
-                                        IsrProfileWrapper<F, Nvic::Index<I>, TimeSource>,
+                                        IsrProfileWrapper<F, Nvic::Index<I>, TimeSource, Policy>,
                                         Nvic::Isr<F, Nvic::Index<I>>>;
     };
 
@@ -219,4 +557,133 @@ namespace Kvasir { namespace Startup {
     template<typename List>
     using FilterWrappersT = typename Detail::FilterWrappersImpl<brigand::list<>, List>::type;
 
+    // -------------------------------------------------------------------
+    // Windowed CPU load
+    // -------------------------------------------------------------------
+
+    // Utilization over the windows currently held by an IsrLoadMonitor.
+    // All loads are in permille of the TimeSource cycles covered by the windows.
+    template<std::size_t IsrCount>
+    struct IsrLoadSnapshot {
+        std::uint32_t                       cycles;           // cycles covered by the windows
+        std::uint16_t                       isrPermille;      // all profiled ISRs together
+        std::uint16_t                       mainPermille;     // main loop and idle
+        std::uint16_t                       peakIsrPermille;  // busiest single window seen
+        std::array<int, IsrCount>           isrIndex;
+        std::array<std::uint16_t, IsrCount> perIsrPermille;
+    };
+
+    // Rolling ISR utilization built from the total duration of the profiled ISRs.
+    // sample() must be called periodically (e.g. every 10 ms from a timer ISR or the
+    // main loop, always from the same context); each call closes one window and the
+    // last Windows windows are kept. Readers use a sequence counter instead of a lock,
+    // so cpuLoad() may be called from any context that cannot preempt sample(). The
+    // duration of a preempted ISR contains the preempting one, so nested ISRs are
+    // counted twice (loads saturate at 1000 permille).
+    template<typename TimeSource, typename WrapperList, std::size_t Windows = 8>
+    struct IsrLoadMonitor;
+
+    template<typename TimeSource, typename... Wrappers, std::size_t Windows>
+    struct IsrLoadMonitor<TimeSource, brigand::list<Wrappers...>, Windows> {
+        static_assert(Windows > 0,
+                      "need at least one window");
+
+        static constexpr std::size_t isrCount = sizeof...(Wrappers);
+
+        using Snapshot = IsrLoadSnapshot<isrCount>;
+
+        struct Window {
+            std::uint32_t                       cycles;
+            std::array<std::uint32_t, isrCount> busy;
+        };
+
+        static void sample() noexcept {
+            std::uint32_t const                       now = TimeSource::now();
+            std::array<std::uint64_t, isrCount> const totals{
+              Wrappers::Stats::duration.total.load(std::memory_order_relaxed)...};
+
+            if(!started) {
+                started   = true;
+                lastTime  = now;
+                lastTotal = totals;
+                return;
+            }
+
+            Window w{now - lastTime, {}};
+            std::uint32_t sum{};
+            for(std::size_t i = 0; i < isrCount; ++i) {
+                w.busy[i] = static_cast<std::uint32_t>(totals[i] - lastTotal[i]);
+                sum += w.busy[i];
+            }
+            lastTime  = now;
+            lastTotal = totals;
+
+            auto const load = permille(sum, w.cycles);
+            if(load > peak.load(std::memory_order_relaxed)) {
+                peak.store(load, std::memory_order_relaxed);
+            }
+
+            // odd sequence = write in progress
+            sequence.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_signal_fence(std::memory_order_release);
+            windows[next] = w;
+            next          = (next + 1) % Windows;
+            if(filled < Windows) { ++filled; }
+            std::atomic_signal_fence(std::memory_order_release);
+            sequence.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // load summed over all held windows (up to Windows * sample period)
+        static Snapshot cpuLoad() noexcept {
+            std::uint32_t                       cycles{};
+            std::array<std::uint64_t, isrCount> busy{};
+            std::uint32_t                       seq{};
+            do {
+                seq = sequence.load(std::memory_order_relaxed);
+                std::atomic_signal_fence(std::memory_order_acquire);
+                cycles = 0;
+                busy   = {};
+                for(std::size_t w = 0; w < filled; ++w) {
+                    cycles += windows[w].cycles;
+                    for(std::size_t i = 0; i < isrCount; ++i) { busy[i] += windows[w].busy[i]; }
+                }
+                std::atomic_signal_fence(std::memory_order_acquire);
+            } while((seq & 1U) != 0 || seq != sequence.load(std::memory_order_relaxed));
+
+            Snapshot s{cycles, 0, 0, peak.load(std::memory_order_relaxed), {Wrappers::IType::value...}, {}};
+
+            std::uint64_t sum{};
+            for(std::size_t i = 0; i < isrCount; ++i) {
+                s.perIsrPermille[i] = permille(busy[i], cycles);
+                sum += busy[i];
+            }
+            s.isrPermille  = permille(sum, cycles);
+            s.mainPermille = static_cast<std::uint16_t>(1000 - s.isrPermille);
+            return s;
+        }
+
+        static std::uint16_t peakLoad() noexcept { return peak.load(std::memory_order_relaxed); }
+
+        static void resetPeak() noexcept { peak.store(0, std::memory_order_relaxed); }
+
+    private:
+        static std::uint16_t permille(std::uint64_t busy,
+                                      std::uint64_t cycles) noexcept {
+            if(cycles == 0) { return 0; }
+            return static_cast<std::uint16_t>(std::min<std::uint64_t>(busy * 1000 / cycles, 1000));
+        }
+
+        // only touched by sample()
+        static inline bool                                started{false};
+        static inline std::uint32_t                       lastTime{};
+        static inline std::array<std::uint64_t, isrCount> lastTotal{};
+
+        // written by sample(), read by cpuLoad() under the sequence counter
+        static inline std::atomic<std::uint32_t>  sequence{0};
+        static inline std::array<Window, Windows> windows{};
+        static inline std::size_t                 next{0};
+        static inline std::size_t                 filled{0};
+        static inline std::atomic<std::uint16_t>  peak{0};
+    };
+
 }}   // namespace Kvasir::Startup
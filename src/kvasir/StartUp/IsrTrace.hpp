@@ -0,0 +1,91 @@
+#pragma once
+
+#include "kvasir/StartUp/TimeSource.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Number of records kept by isrTraceBuffer, must be a power of two.
+#ifndef KVASIR_ISR_TRACE_CAPACITY
+    #define KVASIR_ISR_TRACE_CAPACITY 512
+#endif
+
+namespace Kvasir { namespace Startup {
+
+    enum class IsrTraceKind : std::uint16_t {
+        empty  = 0,   // slot never written
+        isr    = 1,   // id = ISR index, enter/exit = TimeSource timestamps
+        marker = 2,   // id = KVASIR_TRACE_EVENT id, enter = exit = timestamp
+    };
+
+    // Layout is read by cmake/tools/isr_trace_to_chrome.py, keep both in sync.
+    struct IsrTraceRecord {
+        std::uint32_t enter;
+        std::uint32_t exit;
+        std::int16_t  id;
+        IsrTraceKind  kind;
+    };
+
+    static_assert(sizeof(IsrTraceRecord) == 12,
+                  "IsrTraceRecord layout changed");
+
+    // Lock-free ring of ISR and marker records. Every writer reserves its own slot
+    // with a single fetch_add, so ISRs of any priority may write concurrently; once
+    // full the oldest records are overwritten. Stop the trace before dumping the
+    // buffer so no slot changes while it is read.
+    // The whole object is zero-initialized (.bss): writeIndex = 0, recording.
+    template<std::size_t Capacity>
+    struct IsrTraceBuffer {
+        static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0,
+                      "Capacity must be a power of two");
+
+        std::atomic<std::uint32_t>           writeIndex;   // total records ever written
+        std::atomic<std::uint32_t>           stopped;
+        std::array<IsrTraceRecord, Capacity> records;
+
+        void add(IsrTraceKind  kind,
+                 std::int16_t  id,
+                 std::uint32_t enter,
+                 std::uint32_t exit) noexcept {
+            if(stopped.load(std::memory_order_relaxed) != 0) { return; }
+            auto const i = writeIndex.fetch_add(1, std::memory_order_relaxed);
+            records[i & (Capacity - 1)] = {enter, exit, id, kind};
+        }
+
+        template<typename TimeSource>
+        void mark(std::int16_t id) noexcept {
+            std::uint32_t const now = TimeSource::now();
+            add(IsrTraceKind::marker, id, now, now);
+        }
+
+        void stop() noexcept { stopped.store(1, std::memory_order_relaxed); }
+
+        void start() noexcept { stopped.store(0, std::memory_order_relaxed); }
+
+        // only call while stopped
+        void clear() noexcept { writeIndex.store(0, std::memory_order_relaxed); }
+
+        std::size_t size() const noexcept {
+            auto const written = writeIndex.load(std::memory_order_relaxed);
+            return written < Capacity ? written : Capacity;
+        }
+    };
+
+    // The single trace buffer shared by all traced ISRs and KVASIR_TRACE_EVENT markers.
+    // Only emitted if something writes to it.
+    inline IsrTraceBuffer<KVASIR_ISR_TRACE_CAPACITY> isrTraceBuffer{};
+
+}}   // namespace Kvasir::Startup
+
+// Timeline marker, e.g. KVASIR_TRACE_EVENT(3) at the start of a control cycle.
+// Compiles to nothing unless KVASIR_ISR_TRACE is defined.
+#ifdef KVASIR_ISR_TRACE
+    #define KVASIR_TRACE_EVENT(id) \
+        ::Kvasir::Startup::isrTraceBuffer.mark<KVASIR_PROFILE_TIME_SOURCE>(static_cast<std::int16_t>(id))
+#else
+    #define KVASIR_TRACE_EVENT(id) \
+        do {                       \
+        } while(false)
+#endif
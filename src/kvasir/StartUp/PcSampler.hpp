@@ -0,0 +1,146 @@
+#pragma once
+
+#include "kvasir/Common/Interrupt.hpp"
+#include "kvasir/Mpl/Utility.hpp"
+#include "kvasir/Register/Register.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace Kvasir { namespace Startup {
+
+    // One bucket of the sample table; pc = 0 marks an empty bucket.
+    // Layout is read by cmake/tools/pc_sample_profile.py, keep both in sync.
+    struct PcSampleBucket {
+        std::uint32_t pc;      // stacked PC of the interrupted code
+        std::uint32_t lr;      // stacked LR, the caller if the interrupted code is a leaf
+        std::uint32_t count;
+    };
+
+    template<std::size_t Buckets>
+    struct PcSampleTable {
+        static_assert(Buckets >= 16 && (Buckets & (Buckets - 1)) == 0,
+                      "Buckets must be a power of two >= 16");
+
+        // the whole object is zero-initialized (.bss): empty and sampling
+        std::uint32_t                       samples;   // all samples taken
+        std::uint32_t                       dropped;   // samples lost to a full table
+        std::uint32_t                       stopped;
+        std::array<PcSampleBucket, Buckets> buckets;
+
+        // open addressing with linear probing on (pc, lr); only called from the
+        // sampling ISR, readers stop the sampler first
+        void add(std::uint32_t pc,
+                 std::uint32_t lr) noexcept {
+            if(stopped != 0) { return; }
+            ++samples;
+            // Fibonacci hashing, the top bits are the best mixed ones
+            std::uint32_t const h = ((pc >> 1) ^ (lr * 0x9E3779B1U)) * 0x9E3779B1U;
+            std::size_t         i = h >> (32 - log2Buckets);
+            for(std::size_t probe = 0; probe < maxProbes; ++probe) {
+                auto& b = buckets[i];
+                if(b.pc == pc && b.lr == lr) {
+                    ++b.count;
+                    return;
+                }
+                if(b.pc == 0) {
+                    b = {pc, lr, 1};
+                    return;
+                }
+                i = (i + 1) & (Buckets - 1);
+            }
+            ++dropped;
+        }
+
+        // frame = exception stack frame: r0, r1, r2, r3, r12, lr, pc, xpsr
+        void addFrame(std::uint32_t const* frame) noexcept { add(frame[6], frame[5] & ~1U); }
+
+        void stop() noexcept { stopped = 1; }
+
+        void start() noexcept { stopped = 0; }
+
+        // only call while stopped
+        void clear() noexcept {
+            samples = 0;
+            dropped = 0;
+            buckets = {};
+        }
+
+    private:
+        static constexpr std::size_t log2Buckets = [] {
+            std::size_t n{};
+            while((std::size_t{1} << n) < Buckets) { ++n; }
+            return n;
+        }();
+
+        // keeps the worst case ISR time bounded once the table fills up
+        static constexpr std::size_t maxProbes = 16;
+    };
+
+    // Statistical profiler: a periodic high priority timer ISR samples the PC (and
+    // LR) of whatever it interrupted from the exception frame, the same way
+    // Fault::Handler finds the frame on MSP or PSP, and counts them in `table`. Dump
+    // the table after stop() (e.g. J-Link savebin) and symbolize it with
+    // cmake/tools/pc_sample_profile.py for a flat profile and folded stacks.
+    //
+    // Add it to the peripheral list of the Startup; the timer itself (a few kHz,
+    // not a multiple of any control loop frequency) is configured by the
+    // application. TimerInterrupt gets the highest priority so ISRs are sampled
+    // too; AckActions are applied in the ISR to clear the timer's interrupt flag:
+    //   using Sampler = PcSampler<Interrupt::tim7, 512, write(TIM7::SR::uif, 0)>;
+    template<auto TimerInterrupt, std::size_t Buckets = 256, auto... AckActions>
+    struct PcSampler {
+        static constexpr int index = std::remove_cv_t<decltype(TimerInterrupt)>::value;
+
+        static inline PcSampleTable<Buckets> table{};
+
+        static void sample(std::uint32_t const* frame) noexcept {
+            if constexpr(sizeof...(AckActions) != 0) { Register::apply(AckActions...); }
+            table.addFrame(frame);
+        }
+
+        [[gnu::naked]] static void onIsr() {
+#if defined(__thumb__) && __ARM_ARCH_ISA_THUMB == 1
+            // Thumb1 (Cortex-M0/M0+) compatible version
+            asm volatile(
+              "movs r1, #4        \n"
+              "mov r0, lr         \n"
+              "tst r0, r1         \n"
+              "beq 1f             \n"
+              "mrs r0, psp        \n"
+              "b 2f               \n"
+              "1:                 \n"
+              "mrs r0, msp        \n"
+              "2:                 \n"
+              "ldr r1, =%0        \n"
+              "bx r1              \n"
+              :
+              : "i"(std::addressof(sample))
+              : "r0", "r1");
+#elif defined(__thumb__)
+            // Thumb2 (Cortex-M3/M4/M7+) optimized version, tail calls sample(frame)
+            asm volatile(
+              "tst lr, #4         \n"
+              "ite eq             \n"
+              "mrseq r0, msp      \n"
+              "mrsne r0, psp      \n"
+              "b %0               \n"
+              :
+              : "i"(std::addressof(sample))
+              : "r0");
+#endif
+        }
+
+        static constexpr auto initStepInterruptConfig
+          = MPL::list(Nvic::makeSetPriority<0>(Nvic::Index<index>{}));
+
+        static constexpr auto initStepPeripheryEnable
+          = MPL::list(Nvic::makeEnable(Nvic::Index<index>{}));
+
+        using Isr = brigand::list<Nvic::Isr<std::addressof(onIsr), Nvic::Index<index>>>;
+    };
+
+}}   // namespace Kvasir::Startup
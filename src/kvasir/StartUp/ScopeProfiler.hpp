@@ -0,0 +1,117 @@
+#pragma once
+
+#include "kvasir/StartUp/IsrProfiler.hpp"
+#include "kvasir/Util/FixedString.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+// Scope probes are compiled in with logging (they are reported through uc_log) or
+// when explicitly requested, e.g. for host tests.
+#if defined(USE_UC_LOG) || defined(KVASIR_ENABLE_PROFILE_SCOPES)
+    #define KVASIR_PROFILE_SCOPES_ENABLED 1
+#endif
+
+namespace Kvasir { namespace Startup {
+
+    // One registry entry per probe name, collected by the linker in the
+    // kvasir_scope_profiles section (see common_text_body.inc.ld).
+    struct ScopeProfileEntry {
+        char const*               name;
+        std::size_t               nameSize;
+        ProfileStats<true> const* stats;
+
+        std::string_view nameView() const noexcept { return {name, nameSize}; }
+    };
+
+    // Static per-name storage; all KVASIR_PROFILE_SCOPE sites using the same name
+    // (and TimeSource) share one set of statistics.
+    template<FixedString Name, typename TimeSource>
+    struct ScopeProfileSite {
+        static inline ProfileStats<true> stats{};
+
+        // alignas keeps the compiler from over-aligning the entries, they have to form
+        // a gapless array in the section
+        [[gnu::used, gnu::section("kvasir_scope_profiles")]] alignas(
+          ScopeProfileEntry) static constexpr ScopeProfileEntry entry{Name.data,
+                                                                      Name.view().size(),
+                                                                      std::addressof(stats)};
+    };
+
+    // RAII probe, records the time from construction to destruction
+    template<FixedString Name, typename TimeSource>
+    struct ScopeProbe {
+        using Site = ScopeProfileSite<Name, TimeSource>;
+
+        std::uint32_t const enter;
+
+        ScopeProbe() noexcept : enter{TimeSource::now()} {
+            // taking the address instantiates the registry entry
+            (void)std::addressof(Site::entry);
+        }
+
+        ~ScopeProbe() { Site::stats.record(TimeSource::now() - enter); }
+
+        ScopeProbe(ScopeProbe const&)            = delete;
+        ScopeProbe& operator=(ScopeProbe const&) = delete;
+    };
+
+}}   // namespace Kvasir::Startup
+
+#ifdef __arm__
+extern "C" {
+extern std::uintptr_t _LINKER_scope_profiles_start_;
+extern std::uintptr_t _LINKER_scope_profiles_end_;
+}
+#else
+// defined by the host linker for sections named like C identifiers, weak so
+// programs without any probe still link
+extern "C" {
+[[gnu::weak]] extern std::uintptr_t __start_kvasir_scope_profiles;
+[[gnu::weak]] extern std::uintptr_t __stop_kvasir_scope_profiles;
+}
+#endif
+
+namespace Kvasir { namespace Startup {
+
+    // Calls f(ScopeProfileEntry const&) for every probe name linked into the program,
+    // in link order.
+    template<typename F>
+    void forEachScopeProfile(F&& f) {
+#ifdef __arm__
+        auto const* first
+          = reinterpret_cast<ScopeProfileEntry const*>(std::addressof(_LINKER_scope_profiles_start_));
+        auto const* last
+          = reinterpret_cast<ScopeProfileEntry const*>(std::addressof(_LINKER_scope_profiles_end_));
+#else
+        auto const* first
+          = reinterpret_cast<ScopeProfileEntry const*>(std::addressof(__start_kvasir_scope_profiles));
+        auto const* last
+          = reinterpret_cast<ScopeProfileEntry const*>(std::addressof(__stop_kvasir_scope_profiles));
+#endif
+        for(; first != last; ++first) { f(*first); }
+    }
+
+}}   // namespace Kvasir::Startup
+
+#define KVASIR_PROFILE_SCOPE_CONCAT_IMPL(a, b) a##b
+#define KVASIR_PROFILE_SCOPE_CONCAT(a, b)      KVASIR_PROFILE_SCOPE_CONCAT_IMPL(a, b)
+
+// Profiles the rest of the enclosing scope under the given string literal name:
+//   void filterUpdate() {
+//       KVASIR_PROFILE_SCOPE("filter");
+//       ...
+//   }
+// Report with Kvasir::Startup::printScopeProfiles(). Compiles to nothing unless
+// USE_UC_LOG or KVASIR_ENABLE_PROFILE_SCOPES is defined.
+#ifdef KVASIR_PROFILE_SCOPES_ENABLED
+    #define KVASIR_PROFILE_SCOPE(name)                                              \
+        ::Kvasir::Startup::ScopeProbe<name, KVASIR_PROFILE_TIME_SOURCE> const       \
+          KVASIR_PROFILE_SCOPE_CONCAT(kvasirScopeProbe, __COUNTER__) {}
+#else
+    #define KVASIR_PROFILE_SCOPE(name) \
+        do {                           \
+        } while(false)
+#endif
@@ -1,11 +1,15 @@
 #pragma once
 
+#include "kvasir/Atomic/QueueStats.hpp"
 #include "kvasir/Common/Interrupt.hpp"
 #include "kvasir/Common/Tags.hpp"
 #include "kvasir/Mpl/Algorithm.hpp"
 #include "kvasir/Mpl/Utility.hpp"
 #include "kvasir/Register/Register.hpp"
+#include "kvasir/StartUp/CriticalSectionProfiler.hpp"
 #include "kvasir/StartUp/IsrProfiler.hpp"
+#include "kvasir/StartUp/ScopeProfiler.hpp"
+#include "kvasir/Util/StackUsage.hpp"
 #include "kvasir/Util/attributes.hpp"
 #include "kvasir/Util/ubsan.hpp"
 #include "uc_log/uc_log.hpp"
@@ -27,6 +31,18 @@ extern std::size_t    _LINKER_data_size_;
 
 extern std::uintptr_t _LINKER_bss_start_;
 extern std::size_t    _LINKER_bss_size_;
+
+// optional RAM banks, see linker/common.ld; sizes are 0 if the bank is not used
+extern std::uintptr_t _LINKER_fastData_start_flash_;
+extern std::uintptr_t _LINKER_fastData_start_;
+extern std::size_t    _LINKER_fastData_size_;
+extern std::uintptr_t _LINKER_fastBss_start_;
+extern std::size_t    _LINKER_fastBss_size_;
+extern std::uintptr_t _LINKER_dmaBss_start_;
+extern std::size_t    _LINKER_dmaBss_size_;
+extern std::uintptr_t _LINKER_coldData_start_flash_;
+extern std::uintptr_t _LINKER_coldData_start_;
+extern std::size_t    _LINKER_coldData_size_;
 }
 
 namespace Kvasir { namespace Startup {
@@ -284,25 +300,48 @@ namespace Kvasir { namespace Startup {
         (callRuntimeInit<Ts>(), ...);
     }
 
-    [[gnu::always_inline]] inline void initMemory() {
-        auto data_start = std::addressof(_LINKER_data_start_);
-        asm("" : "+l"(data_start)::);
+    // copy table entry: initialized data from its flash image to RAM
+    [[gnu::always_inline]] inline void copyRegion(std::uintptr_t* start,
+                                                  std::uintptr_t* start_flash,
+                                                  std::size_t*    size_symbol) {
+        auto dest = std::addressof(*start);
+        asm("" : "+l"(dest)::);
 
-        auto data_start_flash = std::addressof(_LINKER_data_start_flash_);
-        asm("" : "+l"(data_start_flash)::);
+        auto src = std::addressof(*start_flash);
+        asm("" : "+l"(src)::);
 
-        auto data_size = reinterpret_cast<std::size_t>(std::addressof(_LINKER_data_size_));
-        asm("" : "+l"(data_size)::);
+        auto size = reinterpret_cast<std::size_t>(size_symbol);
+        asm("" : "+l"(size)::);
 
-        std::memcpy(data_start, data_start_flash, data_size);
+        std::memcpy(dest, src, size);
+    }
 
-        auto bss_start = std::addressof(_LINKER_bss_start_);
-        asm("" : "+l"(bss_start)::);
+    // zero table entry
+    [[gnu::always_inline]] inline void zeroRegion(std::uintptr_t* start,
+                                                  std::size_t*    size_symbol) {
+        auto dest = std::addressof(*start);
+        asm("" : "+l"(dest)::);
 
-        auto bss_size = reinterpret_cast<std::size_t>(std::addressof(_LINKER_bss_size_));
-        asm("" : "+l"(bss_size)::);
+        auto size = reinterpret_cast<std::size_t>(size_symbol);
+        asm("" : "+l"(size)::);
 
-        std::memset(bss_start, 0, bss_size);
+        std::memset(dest, 0, size);
+    }
+
+    [[gnu::always_inline]] inline void initMemory() {
+        copyRegion(std::addressof(_LINKER_data_start_),
+                   std::addressof(_LINKER_data_start_flash_),
+                   std::addressof(_LINKER_data_size_));
+        copyRegion(std::addressof(_LINKER_fastData_start_),
+                   std::addressof(_LINKER_fastData_start_flash_),
+                   std::addressof(_LINKER_fastData_size_));
+        copyRegion(std::addressof(_LINKER_coldData_start_),
+                   std::addressof(_LINKER_coldData_start_flash_),
+                   std::addressof(_LINKER_coldData_size_));
+
+        zeroRegion(std::addressof(_LINKER_bss_start_), std::addressof(_LINKER_bss_size_));
+        zeroRegion(std::addressof(_LINKER_fastBss_start_), std::addressof(_LINKER_fastBss_size_));
+        zeroRegion(std::addressof(_LINKER_dmaBss_start_), std::addressof(_LINKER_dmaBss_size_));
     }
 
     [[gnu::always_inline]] inline void callGlobalConstructors() {
@@ -340,6 +379,9 @@ namespace Kvasir { namespace Startup {
 
                 ClockSettings::coreClockInit();
 
+                // only ResetISR's own frame is live yet, see stackHighWater()
+                paintStack();
+
                 initMemory();
 
                 callGlobalConstructors();
@@ -450,6 +492,37 @@ namespace Kvasir { namespace Startup {
                          p.minDurationCycles,
                          p.avgDurationCycles,
                          p.maxDurationCycles);
+                if(p.latencyCount != 0) {
+                    UC_LOG_T("    latency   min:{:>10}  avg:{:>10}  max:{:>10}  cyc",
+                             p.minLatencyCycles,
+                             p.avgLatencyCycles,
+                             p.maxLatencyCycles);
+                }
+                if(p.deadlineViolations != 0) {
+                    UC_LOG_T("    deadline  misses:{:>7}  worst overrun:{:>10} cyc at {}",
+                             p.deadlineViolations,
+                             p.worstOverrunCycles,
+                             p.worstOverrunTime);
+                }
+            }
+        }
+
+        // Rolling utilization of the profiled ISRs, see IsrLoadMonitor.
+        // LoadMonitor<>::sample() has to be called periodically by the application.
+        template<std::size_t Windows = 8>
+        using LoadMonitor = IsrLoadMonitor<TimeSource, ProfiledWrapperList, Windows>;
+
+        template<typename Monitor = LoadMonitor<>>
+        static void printCpuLoad() {
+            [[maybe_unused]] auto const load = Monitor::cpuLoad();
+            UC_LOG_T("{:#^32}", " CPU load "_sc);
+            UC_LOG_T("  isr:{:>5}/1000  main:{:>5}/1000  peak isr:{:>5}/1000  over {} cyc",
+                     load.isrPermille,
+                     load.mainPermille,
+                     load.peakIsrPermille,
+                     load.cycles);
+            for(std::size_t i = 0; i < Monitor::isrCount; ++i) {
+                UC_LOG_T("  isr[{:3}]  {:>5}/1000", load.isrIndex[i], load.perIsrPermille[i]);
             }
         }
 
@@ -462,6 +535,82 @@ namespace Kvasir { namespace Startup {
         }
     };
 
+    // Report of all KVASIR_PROFILE_SCOPE probes linked into the firmware, with the
+    // non-empty buckets of the log2 duration histogram.
+    inline void printScopeProfiles() {
+        UC_LOG_T("{:#^32}", " scope profiles "_sc);
+        forEachScopeProfile([]([[maybe_unused]] ScopeProfileEntry const& e) {
+            [[maybe_unused]] auto const& s = *e.stats;
+            UC_LOG_T("  {}  calls: {}", e.nameView(), s.count.load(std::memory_order_relaxed));
+            UC_LOG_T("    duration  min:{:>10}  avg:{:>10}  max:{:>10}  cyc",
+                     s.minimum(),
+                     s.average(),
+                     s.maximum());
+            for(std::size_t b = 0; b < profileHistogramBuckets; ++b) {
+                [[maybe_unused]] auto const n = s.histogram[b].load(std::memory_order_relaxed);
+                if(n != 0) {
+                    UC_LOG_T("    < 2^{:<2} cyc: {:>10}", b, n);
+                }
+            }
+        });
+    }
+
+    // Report of all queues with OverFlowPolicyStats linked into the firmware, to size
+    // them by their high water mark.
+    inline void printQueueStats() {
+        UC_LOG_T("{:#^32}", " queues "_sc);
+        Atomic::forEachQueueStats([]([[maybe_unused]] Atomic::QueueStatsEntry const& e) {
+            [[maybe_unused]] auto const& s = *e.stats;
+            UC_LOG_T("  {}  used:{:>8}  of:{:>8}  pushes:{:>10}  overflows:{:>8}",
+                     e.nameView(),
+                     s.highWater.load(std::memory_order_relaxed),
+                     e.capacity,
+                     s.pushes.load(std::memory_order_relaxed),
+                     s.overflows.load(std::memory_order_relaxed));
+        });
+    }
+
+    // Deepest stack use since reset, see Kvasir::stackHighWater().
+    inline void printStackUsage() {
+        [[maybe_unused]] auto const u = stackHighWater();
+        UC_LOG_T("{:#^32}", " stack "_sc);
+        UC_LOG_T("  used:{:>8}  of:{:>8}  bytes  free:{:>8}", u.highWater, u.size, u.size - u.highWater);
+    }
+
+#ifdef KVASIR_PROFILE_CRITICAL_SECTIONS
+    // Report of the masked time of every InterruptGuard<Global> call site seen so far,
+    // with the non-empty buckets of the log2 histogram. Each site is copied under a
+    // guard, so the report itself shows up as a site as well.
+    inline void printCriticalSections() {
+        UC_LOG_T("{:#^32}", " critical sections "_sc);
+        for(std::size_t i = 0; i < criticalSections.sites.size(); ++i) {
+            CriticalSectionSite s;
+            {
+                Nvic::InterruptGuard<Nvic::Global> guard{};
+                s = criticalSections.sites[i];
+            }
+            if(s.file == nullptr) { continue; }
+            UC_LOG_T("  {}:{}:{}  calls: {}",
+                     std::string_view{s.file},
+                     s.line,
+                     s.column,
+                     s.count);
+            UC_LOG_T("    {}", std::string_view{s.function});
+            if(s.caller != nullptr) {
+                UC_LOG_T("    called from {:#010x}", reinterpret_cast<std::uintptr_t>(s.caller));
+            }
+            UC_LOG_T("    masked  avg:{:>10}  max:{:>10}  cyc", s.average(), s.maxCycles);
+            for(std::size_t b = 0; b < profileHistogramBuckets; ++b) {
+                if(s.histogram[b] != 0) { UC_LOG_T("    < 2^{:<2} cyc: {:>10}", b, s.histogram[b]); }
+            }
+        }
+        if(criticalSections.dropped != 0) {
+            UC_LOG_T("  {} sections of untracked sites, raise KVASIR_CRITICAL_SECTION_SITES",
+                     criticalSections.dropped);
+        }
+    }
+#endif
+
 }}   // namespace Kvasir::Startup
 
 #ifdef __arm__
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "kvasir/Common/Interrupt.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+#ifndef __arm__
+    #include <chrono>
+#endif
+
+// Time source used by profiling probes outside of the ISR wrappers (trace markers,
+// scope probes, critical sections); must match the TimeSource passed to
+// StartupWithProfiling.
+#ifndef KVASIR_PROFILE_TIME_SOURCE
+    #define KVASIR_PROFILE_TIME_SOURCE ::Kvasir::Startup::DwtTimeSource
+#endif
+
+namespace Kvasir { namespace Startup {
+
+    // Log2 histogram bucket of a cycle count: bucket b holds values with bit width b,
+    // i.e. 0 -> 0, 1 -> 1, 2..3 -> 2, ..., 2^31..2^32-1 -> 32.
+    inline constexpr std::size_t profileHistogramBuckets = 33;
+
+    // Default time source: ARM DWT cycle counter (Cortex-M3/M4/M7/M33)
+    struct DwtTimeSource {
+        static std::uint32_t now() noexcept {
+            return *reinterpret_cast<std::uint32_t const volatile*>(0xE0001004U);   // DWT_CYCCNT
+        }
+
+        // Must be called once before any ISR fires (before Nvic::enable_all)
+        static void enable() noexcept {
+            // Enable trace subsystem: CoreDebug->DEMCR TRCENA bit
+            *reinterpret_cast<std::uint32_t volatile*>(0xE000EDFC) |= (1U << 24);
+            // Reset and enable cycle counter: DWT_CTRL CYCCNTENA bit
+            *reinterpret_cast<std::uint32_t volatile*>(0xE0001004) = 0;   // reset CYCCNT
+            *reinterpret_cast<std::uint32_t volatile*>(0xE0001000) |= 1U;
+        }
+    };
+
+    namespace Detail {
+        // Monotonic time of a down-counter running from Reload to 0 after `reloads`
+        // completed periods. wrapPending: the counter wrapped but the reload was not
+        // counted yet (reload ISR pending while a higher priority context reads).
+        // SysTick pends on the 1 -> 0 step and reloads one clock later, so a pending
+        // flag seen with current == 0 still belongs to the running period.
+        // Wraps cleanly at 2^32 if the period (Reload + 1) divides 2^32.
+        constexpr std::uint32_t downCounterCycles(std::uint32_t reloads,
+                                                  std::uint32_t reload,
+                                                  std::uint32_t current,
+                                                  bool          wrapPending) noexcept {
+            if(wrapPending && current != 0) { ++reloads; }
+            return reloads * (reload + 1) + (reload - current);
+        }
+
+        // Extends a free-running up-counter of Bits bits to 32 bits. Correct as long
+        // as it is called at least once per counter period.
+        template<unsigned Bits>
+        constexpr std::uint32_t extendCounter(std::uint32_t previous,
+                                              std::uint32_t raw) noexcept {
+            static_assert(Bits > 0 && Bits <= 32,
+                          "counter width out of range");
+            if constexpr(Bits == 32) {
+                return raw;
+            } else {
+                constexpr std::uint32_t mask = (std::uint32_t{1} << Bits) - 1;
+                return previous + ((raw - previous) & mask);
+            }
+        }
+    }   // namespace Detail
+
+    // Time source for cores without DWT_CYCCNT (Cortex-M0/M0+): the 24 bit SysTick
+    // down-counter running at core clock plus a reload count kept by its ISR. Add
+    // it to the peripheral list of the Startup so its Isr gets installed; SysTick
+    // must not be used for anything else. SysTickInterrupt is the SysTick index of
+    // the chip (-1 in the usual numbering).
+    template<auto SysTickInterrupt = Nvic::Index<-1>{}>
+    struct SysTickTimeSource {
+        static constexpr std::uint32_t reload = 0x00FFFFFF;   // period 2^24 divides 2^32
+
+        static std::uint32_t now() noexcept {
+            std::uint32_t r{};
+            std::uint32_t current{};
+            bool          pending{};
+            // retry if the reload ISR ran or the counter wrapped while reading
+            while(true) {
+                r                   = reloads.load(std::memory_order_relaxed);
+                bool const pending1 = wrapPending();
+                current             = cvr();
+                pending             = wrapPending();
+                if(pending1 == pending && r == reloads.load(std::memory_order_relaxed)) { break; }
+            }
+            return Detail::downCounterCycles(r, reload, current, pending);
+        }
+
+        // Must be called once before any ISR fires (before Nvic::enable_all)
+        static void enable() noexcept {
+            *reinterpret_cast<std::uint32_t volatile*>(0xE000E010) = 0;        // SYST_CSR: stop
+            *reinterpret_cast<std::uint32_t volatile*>(0xE000E014) = reload;   // SYST_RVR
+            *reinterpret_cast<std::uint32_t volatile*>(0xE000E018) = 0;        // SYST_CVR: clear
+            // CLKSOURCE = core clock, TICKINT, ENABLE
+            *reinterpret_cast<std::uint32_t volatile*>(0xE000E010) = 0b111;
+        }
+
+        static void onIsr() noexcept { reloads.fetch_add(1, std::memory_order_relaxed); }
+
+        using Isr = brigand::list<
+          Nvic::Isr<std::addressof(onIsr),
+                    Nvic::Index<std::remove_cv_t<decltype(SysTickInterrupt)>::value>>>;
+
+    private:
+        static inline std::atomic<std::uint32_t> reloads{0};
+
+        static std::uint32_t cvr() noexcept {
+            return *reinterpret_cast<std::uint32_t const volatile*>(0xE000E018);   // SYST_CVR
+        }
+
+        static bool wrapPending() noexcept {
+            // SCB_ICSR PENDSTSET
+            return (*reinterpret_cast<std::uint32_t const volatile*>(0xE000ED04) & (1U << 26))
+                != 0;
+        }
+    };
+
+    // Time source on a free-running chip timer counting up. Timer provides
+    //   static std::uint32_t count() noexcept;   // raw counter value
+    //   static constexpr unsigned bits;          // counter width, 1..32
+    //   static void enable() noexcept;           // optional, starts the timer
+    // Narrower counters are extended to 32 bits, which requires now() to be called
+    // at least once per counter period (e.g. by a profiled ISR or a periodic tick).
+    template<typename Timer>
+    struct TimerTimeSource {
+        static std::uint32_t now() noexcept {
+            if constexpr(Timer::bits == 32) {
+                return Timer::count();
+            } else {
+                std::uint32_t old = extended.load(std::memory_order_relaxed);
+                std::uint32_t next{};
+                do {
+                    next = Detail::extendCounter<Timer::bits>(old, Timer::count());
+                } while(!extended.compare_exchange_weak(old, next, std::memory_order_relaxed));
+                return next;
+            }
+        }
+
+        static void enable() noexcept {
+            if constexpr(requires { Timer::enable(); }) { Timer::enable(); }
+        }
+
+    private:
+        static inline std::atomic<std::uint32_t> extended{0};
+    };
+
+#ifndef __arm__
+    // Host time source in nanoseconds of std::chrono::steady_clock, truncated to 32
+    // bit like the cycle counters (wraps after ~4.3 s, durations stay correct).
+    // Lets the profiler run in host tests and benchmarks.
+    struct HostTimeSource {
+        static std::uint32_t now() noexcept {
+            return static_cast<std::uint32_t>(
+              std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+        }
+
+        static void enable() noexcept {}
+    };
+#endif
+
+}}   // namespace Kvasir::Startup
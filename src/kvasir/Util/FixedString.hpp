@@ -0,0 +1,19 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+
+namespace Kvasir {
+
+// string literal usable as template argument, e.g. names of registry entries
+template<std::size_t N>
+struct FixedString {
+    char data[N]{};
+
+    constexpr FixedString(char const (&str)[N]) { std::copy_n(str, N, data); }
+
+    constexpr std::string_view view() const { return {data, N - 1}; }
+};
+
+}   // namespace Kvasir
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Kvasir {
+
+namespace Detail {
+    // PMSAv7 RASR.SIZE field: region size is 2^(SIZE + 1) bytes
+    constexpr std::uint32_t mpuRegionSizeField(std::size_t size) {
+        std::uint32_t n{};
+        while((std::size_t{1} << (n + 1)) < size) { ++n; }
+        return n;
+    }
+
+    static_assert(mpuRegionSizeField(32) == 4);
+    static_assert(mpuRegionSizeField(256) == 7);
+    static_assert(mpuRegionSizeField(1024) == 9);
+}   // namespace Detail
+
+// Drop-in replacement for StackProtector: instead of polling a sentinel the bottom
+// of the stack (.stackProtector, see common_stack_body.inc.ld) is made inaccessible,
+// so an overflow faults on the first access. Fault::Handler moves SP away from the
+// overflowed stack before it logs, so it can report the fault; without it the fault
+// escalates to a HardFault.
+//
+// ARMv7-M/ARMv6-M with MPU: Region is programmed no-access and execute-never,
+// PRIVDEFENA keeps the default memory map for everything else.
+// ARMv8-M Baseline (PMSAv8, no MSPLIM for non-secure code): Region is programmed
+// privileged read-only and execute-never, PMSAv8 has no no-access permission, so
+// pushes into the guard fault but reads do not.
+// ARMv8-M Mainline: MSPLIM is set to the top of the guard (UsageFault STKOF), no MPU
+// region is used.
+// Size has to cover the largest single SP decrement (an FPU exception frame is 104
+// bytes, big locals more), otherwise a frame steps over the guard; 256 is also the
+// minimum region size of ARMv6-M.
+// Add it to the peripheral list of the Startup, it is armed before interrupts are
+// enabled; handler() is empty so existing polling code keeps compiling.
+template<std::size_t Size = 256, std::uint32_t Region = 0>
+struct MpuStackGuard {
+    static_assert(Size >= 32 && (Size & (Size - 1)) == 0,
+                  "Size must be a power of two >= 32");
+#ifdef __ARM_ARCH_6M__
+    static_assert(Size >= 256, "the ARMv6-M MPU has no regions below 256 bytes");
+#endif
+
+    // the MPU needs the region aligned to its size
+    [[gnu::section(".stackProtector")]] alignas(Size) static inline std::array<std::byte,
+                                                                             Size> guard{};
+
+    static void preEnableRuntimeInit() {
+        auto const base = reinterpret_cast<std::uint32_t>(std::addressof(guard));
+#if defined(__ARM_ARCH_8M_MAIN__) || defined(__ARM_ARCH_8_1M_MAIN__)
+        asm volatile("msr msplim, %0" : : "r"(base + Size) : "memory");
+#elif defined(__ARM_ARCH_8M_BASE__)
+        auto reg = [](std::uint32_t address) -> std::uint32_t volatile& {
+            return *reinterpret_cast<std::uint32_t volatile*>(address);
+        };
+        reg(0xE000ED98) = Region;   // MPU_RNR
+        // MPU_RBAR: BASE, AP = privileged read-only, XN
+        reg(0xE000ED9C) = base | (0b10U << 1) | 1U;
+        // MPU_RLAR: LIMIT, AttrIndx 0, ENABLE
+        reg(0xE000EDA0) = ((base + Size - 1) & ~0x1FU) | 1U;
+        reg(0xE000ED94) = (1U << 2) | 1U;   // MPU_CTRL: PRIVDEFENA, ENABLE
+        asm volatile(
+          "dsb\n"
+          "isb\n"
+          :
+          :
+          : "memory");
+#else
+        auto reg = [](std::uint32_t address) -> std::uint32_t volatile& {
+            return *reinterpret_cast<std::uint32_t volatile*>(address);
+        };
+        reg(0xE000ED98) = Region;   // MPU_RNR
+        reg(0xE000ED9C) = base;     // MPU_RBAR
+        // MPU_RASR: XN, AP = no access, SIZE, ENABLE
+        reg(0xE000EDA0) = (1U << 28) | (Detail::mpuRegionSizeField(Size) << 1) | 1U;
+        reg(0xE000ED94) = (1U << 2) | 1U;   // MPU_CTRL: PRIVDEFENA, ENABLE
+        asm volatile(
+          "dsb\n"
+          "isb\n"
+          :
+          :
+          : "memory");
+#endif
+    }
+
+    static void handler() {}
+};
+}   // namespace Kvasir
@@ -8,6 +8,8 @@
 
 namespace Kvasir {
 
+// Sentinel at the bottom of the stack, checked when handler() is polled. See
+// MpuStackGuard for a variant that faults on the overflow itself.
 template<std::size_t Size = 32>
 struct StackProtector {
     static constexpr std::uint32_t sentinelVal{0x55AA55AA};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#ifdef __arm__
+extern "C" {
+extern std::uint32_t _LINKER_stackProtector_end_;
+extern void          _LINKER_stack_end_();   // declared like in StartUp.hpp (vector table entry)
+}
+#endif
+
+namespace Kvasir {
+
+// Stack high-water mark: ResetISR paints the unused stack with stackPaintPattern,
+// stackHighWater() finds the deepest word that was overwritten since. Use the peak
+// of a long test run (plus a margin for untested paths) to size MIN_STACK_SIZE.
+inline constexpr std::uint32_t stackPaintPattern{0xC5ACCE55};
+
+namespace Detail {
+    // number of painted words at the bottom of [bottom, top), the stack grows down
+    // towards bottom so these were never used
+    inline std::size_t paintedWords(std::uint32_t const volatile* bottom,
+                                    std::uint32_t const volatile* top) noexcept {
+        auto p = bottom;
+        // four words per iteration, the used part is usually reached late
+        while(top - p >= 4) {
+            if(p[0] != stackPaintPattern || p[1] != stackPaintPattern
+               || p[2] != stackPaintPattern || p[3] != stackPaintPattern)
+            {
+                break;
+            }
+            p += 4;
+        }
+        while(p != top && *p == stackPaintPattern) { ++p; }
+        return static_cast<std::size_t>(p - bottom);
+    }
+
+    // volatile keeps the compiler from turning the loop into a memset call, which
+    // would run on the stack being painted; always_inline for the same reason, a
+    // frame of its own would lie below the SP paintStack() passes in and be painted
+    [[gnu::always_inline]] inline void paint(std::uint32_t volatile* bottom,
+                                             std::uint32_t volatile* top) noexcept {
+        for(auto p = bottom; p < top; ++p) { *p = stackPaintPattern; }
+    }
+}   // namespace Detail
+
+#ifdef __arm__
+struct StackUsage {
+    std::size_t size;        // usable stack, without the StackProtector sentinel
+    std::size_t highWater;   // deepest use since reset
+};
+
+// Paints from the top of the .stackProtector sentinel up to the current SP. Called
+// by ResetISR before anything else runs on the stack.
+[[gnu::always_inline]] inline void paintStack() {
+    std::uint32_t* sp;
+    asm volatile("mov %0, sp" : "=r"(sp));
+    Detail::paint(std::addressof(_LINKER_stackProtector_end_), sp);
+}
+
+[[nodiscard]] inline StackUsage stackHighWater() {
+    auto const* bottom = std::addressof(_LINKER_stackProtector_end_);
+    auto const* top    = reinterpret_cast<std::uint32_t const*>(std::addressof(_LINKER_stack_end_));
+    auto const  size   = static_cast<std::size_t>(top - bottom) * sizeof(std::uint32_t);
+    return {size, size - Detail::paintedWords(bottom, top) * sizeof(std::uint32_t)};
+}
+#endif
+
+}   // namespace Kvasir
@@ -9,3 +9,35 @@
     #define KVASIR_RAM_FUNC_INLINE_ATTRIBUTES gnu::section(".data"), gnu::always_inline
     #define KVASIR_RESETISR_ATTRIBUTES        noreturn, gnu::naked
 #endif
+
+// Data placement into the optional RAM banks, e.g. [[KVASIR_HOT_DATA]] static int x{1};
+// The chip enables a bank with the linker include (linker/common_*_ram.ld) plus the
+// compile definition; without it the macro is empty and the variable stays in .data/.bss.
+//   KVASIR_HOT_DATA   initialized, copied from flash to fast_ram (DTCM)
+//   KVASIR_HOT_BSS    zeroed in fast_ram
+//   KVASIR_DMA_DATA   zeroed in dma_ram (DMA reachable, non-cacheable), no initializers
+//   KVASIR_COLD_DATA  initialized, copied from flash to cold_ram
+#ifdef KVASIR_FAST_RAM
+    #define KVASIR_HOT_DATA gnu::section(".fastData")
+    #define KVASIR_HOT_BSS  gnu::section(".fastBss")
+#else
+    #define KVASIR_HOT_DATA
+    #define KVASIR_HOT_BSS
+#endif
+
+#ifdef KVASIR_DMA_RAM
+    #define KVASIR_DMA_DATA gnu::section(".dmaBss")
+#else
+    #define KVASIR_DMA_DATA
+#endif
+
+#ifdef KVASIR_COLD_RAM
+    #define KVASIR_COLD_DATA gnu::section(".coldData")
+#else
+    #define KVASIR_COLD_DATA
+#endif
+
+// Static storage that is neither copied nor zeroed at startup (.noInit, always present),
+// for big buffers that are set up explicitly, e.g. [[KVASIR_NO_INIT]] static Queue<...> q;
+// with q.init() before first use. Survives a warm reset.
+#define KVASIR_NO_INIT gnu::section(".noInit")
@@ -0,0 +1,139 @@
+// Tests for the sequence lock behind the 64 bit and odd sized atomics on Cortex-M
+// (src/kvasir/Atomic/detail/seqlock_atomic.hpp): host threads stand in for the ISRs,
+// a mutex for the global InterruptGuard of the writers.
+#include "kvasir_test.hpp"
+
+#include "kvasir/Atomic/detail/seqlock_atomic.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <print>
+#include <thread>
+#include <vector>
+
+using namespace Kvasir::Test;
+using CommonAtomic::SeqLock;
+
+static void sequenceCounting() {
+    test("sequenceCounting");
+
+    SeqLock       lock{};
+    std::uint64_t value{};
+    lock.write([&]() {
+        CHECK_EQ(lock.sequence.load() % 2, 1u);   // odd while writing
+        value = 0x1122334455667788;
+    });
+    CHECK_EQ(lock.sequence.load(), 2u);
+
+    std::uint64_t read{};
+    lock.read([&]() { read = value; });
+    CHECK_EQ(read, 0x1122334455667788u);
+    CHECK_EQ(lock.sequence.load(), 2u);   // readers do not write
+}
+
+// every word of the value is the same, a torn read has differing words
+static void noTornReads() {
+    test("noTornReads");
+
+    constexpr std::uint32_t writers   = 2;
+    constexpr std::uint32_t readers   = 2;
+    constexpr std::uint32_t perWriter = 20000;
+
+    SeqLock                    lock{};
+    std::mutex                 guard;
+    std::uint32_t volatile     shared[4]{};
+    std::atomic<bool>          done{};
+    std::atomic<std::uint32_t> torn{};
+    std::atomic<std::uint64_t> reads{};
+
+    std::vector<std::thread> threads;
+    for(std::uint32_t r = 0; r != readers; ++r) {
+        threads.emplace_back([&]() {
+            std::uint64_t n{};
+            std::uint32_t last{};
+            while(!done.load(std::memory_order_relaxed)) {
+                std::array<std::uint32_t, 4> w;
+                lock.read([&]() {
+                    for(std::size_t i = 0; i != w.size(); ++i) {
+                        w[i] = shared[i];
+                        if(i == 1) { std::this_thread::yield(); }
+                    }
+                });
+                if(w[0] != w[1] || w[1] != w[2] || w[2] != w[3] || w[0] < last) { ++torn; }
+                last = w[0];
+                ++n;
+            }
+            reads += n;
+        });
+    }
+    for(std::uint32_t t = 0; t != writers; ++t) {
+        threads.emplace_back([&]() {
+            for(std::uint32_t i = 0; i != perWriter; ++i) {
+                std::lock_guard l{guard};
+                lock.write([&]() {
+                    std::uint32_t const next = shared[0] + 1;
+                    for(auto& word : shared) {
+                        word = next;
+                        // lets readers run in the middle of the write even on one CPU
+                        if(i % 256 == 0) { std::this_thread::yield(); }
+                    }
+                });
+            }
+        });
+    }
+    for(std::size_t t = readers; t != threads.size(); ++t) { threads[t].join(); }
+    done = true;
+    for(std::size_t t = 0; t != readers; ++t) { threads[t].join(); }
+
+    CHECK_EQ(torn.load(), 0u);
+    CHECK(reads.load() != 0);
+    CHECK_EQ(shared[0], writers * perWriter);
+    CHECK_EQ(lock.sequence.load(), 2 * writers * perWriter);
+}
+
+// 64 bit value with both words written on every update
+static void bothWords() {
+    test("bothWords");
+
+    constexpr std::uint32_t increments = 100000;
+
+    SeqLock                    lock{};
+    std::mutex                 guard;
+    std::uint64_t volatile     counter{};
+    std::atomic<bool>          done{};
+    std::atomic<std::uint32_t> bad{};
+
+    std::thread reader{[&]() {
+        std::uint64_t last{};
+        while(!done.load(std::memory_order_relaxed)) {
+            std::uint64_t v{};
+            lock.read([&]() { v = counter; });
+            // every written value has the same upper and lower word
+            if((v >> 32) != (v & 0xFFFF'FFFF) || v < last) { ++bad; }
+            last = v;
+        }
+    }};
+    for(std::uint32_t i = 0; i != increments; ++i) {
+        std::lock_guard l{guard};
+        lock.write([&]() { counter = counter + 0x1'0000'0001; });
+    }
+    done = true;
+    reader.join();
+
+    CHECK_EQ(bad.load(), 0u);
+    CHECK_EQ(counter >> 32, std::uint64_t{increments});
+}
+
+int main() {
+    sequenceCounting();
+    noTornReads();
+    bothWords();
+
+    if(Kvasir::Test::failures != 0) {
+        std::print("{} checks failed\n", Kvasir::Test::failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,161 @@
+// Tests for the call site table behind the critical section profiling of
+// InterruptGuard: keying by source_location and caller, statistics and the full table
+// case.
+#include "kvasir_test.hpp"
+
+#include "kvasir/StartUp/CriticalSectionProfiler.hpp"
+
+#include <cstdint>
+#include <print>
+#include <source_location>
+#include <string>
+#include <string_view>
+
+using namespace Kvasir::Test;
+using namespace Kvasir::Startup;
+
+template<std::size_t Sites>
+static CriticalSectionSite const* find(CriticalSectionTable<Sites> const& t,
+                                       std::uint32_t                      line) {
+    for(auto const& s : t.sites) {
+        if(s.file != nullptr && s.line == line) { return &s; }
+    }
+    return nullptr;
+}
+
+static std::source_location here(std::source_location const& loc = std::source_location::current()) {
+    return loc;
+}
+
+static void perSiteStatistics() {
+    test("perSiteStatistics");
+
+    static CriticalSectionTable<8> t{};
+    auto const                     a = here();
+    auto const                     b = here();
+    t.record(a, 10);
+    t.record(a, 30);
+    t.record(a, 2);
+    t.record(b, 1000);
+
+    auto const* sa = find(t, a.line());
+    auto const* sb = find(t, b.line());
+    CHECK(sa != nullptr);
+    CHECK(sb != nullptr);
+    if(sa == nullptr || sb == nullptr) { return; }
+
+    CHECK_EQ(sa->count, 3u);
+    CHECK_EQ(sa->maxCycles, 30u);
+    CHECK_EQ(sa->totalCycles, 42u);
+    CHECK_EQ(sa->average(), 14u);
+    CHECK_EQ(sa->histogram[2], 1u);   // 2
+    CHECK_EQ(sa->histogram[4], 1u);   // 10
+    CHECK_EQ(sa->histogram[5], 1u);   // 30
+    CHECK(std::string_view{sa->file} == a.file_name());
+
+    CHECK_EQ(sb->count, 1u);
+    CHECK_EQ(sb->maxCycles, 1000u);
+    CHECK_EQ(sb->histogram[10], 1u);
+    CHECK_EQ(t.dropped, 0u);
+}
+
+// the file name of a location may be a different string in another translation unit
+static void sameFileOtherPointer() {
+    test("sameFileOtherPointer");
+
+    static CriticalSectionTable<8> t{};
+    static std::string const       copy{here().file_name()};
+    auto const                     loc = here();
+    t.record(loc, 5);
+    for(auto& s : t.sites) {
+        if(s.file != nullptr) { s.file = copy.c_str(); }
+    }
+    t.record(loc, 7);
+
+    auto const* s = find(t, loc.line());
+    CHECK(s != nullptr);
+    if(s == nullptr) { return; }
+    CHECK_EQ(s->count, 2u);
+    CHECK_EQ(s->maxCycles, 7u);
+}
+
+// one guard in shared code (the atomic runtime helpers) seen from different callers
+static void perCallerSites() {
+    test("perCallerSites");
+
+    static CriticalSectionTable<8> t{};
+    static int                     callerA{};
+    static int                     callerB{};
+    auto const                     loc = here();
+    t.record(loc, 5, &callerA);
+    t.record(loc, 7, &callerB);
+    t.record(loc, 9, &callerA);
+    t.record(loc, 1);
+
+    CriticalSectionSite const* sa{};
+    CriticalSectionSite const* sb{};
+    CriticalSectionSite const* sn{};
+    for(auto const& s : t.sites) {
+        if(s.file == nullptr) { continue; }
+        CHECK_EQ(s.line, loc.line());
+        if(s.caller == &callerA) { sa = &s; }
+        if(s.caller == &callerB) { sb = &s; }
+        if(s.caller == nullptr) { sn = &s; }
+    }
+    CHECK(sa != nullptr);
+    CHECK(sb != nullptr);
+    CHECK(sn != nullptr);
+    if(sa == nullptr || sb == nullptr || sn == nullptr) { return; }
+    CHECK_EQ(sa->count, 2u);
+    CHECK_EQ(sa->maxCycles, 9u);
+    CHECK_EQ(sb->count, 1u);
+    CHECK_EQ(sb->maxCycles, 7u);
+    CHECK_EQ(sn->count, 1u);
+    CHECK_EQ(t.dropped, 0u);
+}
+
+// more sites than slots: every section is either counted or dropped
+static void fullTable() {
+    test("fullTable");
+
+    static CriticalSectionTable<4> t{};
+    auto const                     base = here();
+    for(std::uint32_t i = 0; i != 10; ++i) {
+        t.record(std::source_location{base}, 1);   // same site
+    }
+    CHECK_EQ(find(t, base.line())->count, 10u);
+
+    // distinct sites differ in line
+    auto const l1 = here();
+    auto const l2 = here();
+    auto const l3 = here();
+    auto const l4 = here();
+    for(auto const& l : {l1, l2, l3, l4}) { t.record(l, 1); }
+
+    std::uint32_t counted{};
+    std::uint32_t used{};
+    for(auto const& s : t.sites) {
+        counted += s.count;
+        if(s.file != nullptr) { ++used; }
+    }
+    CHECK_EQ(used, 4u);
+    CHECK_EQ(counted + t.dropped, 14u);
+    CHECK_EQ(t.dropped, 1u);
+
+    t.clear();
+    CHECK_EQ(t.dropped, 0u);
+    CHECK(find(t, base.line()) == nullptr);
+}
+
+int main() {
+    perSiteStatistics();
+    sameFileOtherPointer();
+    perCallerSites();
+    fullTable();
+
+    if(Kvasir::Test::failures != 0) {
+        std::print("{} checks failed\n", Kvasir::Test::failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+// Benchmark of the per-call cost of the ISR profiler: IsrProfileStats::record alone and
+// the complete IsrProfileWrapper::onIsr with HostTimeSource, uncontended and with
+// several threads updating the same statistics. Not run by ctest, build and run
+// kvasir_benchmark_isr_profiler manually (in a Release build).
+#include "kvasir/StartUp/IsrProfiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <print>
+#include <thread>
+#include <vector>
+
+using namespace Kvasir::Startup;
+using Kvasir::Nvic::Index;
+
+static void emptyIsr() {}
+
+template<typename F>
+static double nsPerCall(std::uint32_t threads,
+                        std::uint32_t perThread,
+                        F             f) {
+    std::atomic<bool>        go{false};
+    std::vector<std::thread> workers;
+    for(std::uint32_t t = 0; t != threads; ++t) {
+        workers.emplace_back([&go, &f, perThread] {
+            while(!go.load(std::memory_order_acquire)) {}
+            for(std::uint32_t i = 0; i != perThread; ++i) { f(i); }
+        });
+    }
+    auto const start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for(auto& w : workers) { w.join(); }
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count()
+         / static_cast<double>(std::uint64_t{threads} * perThread);
+}
+
+template<int I>
+static void benchRecord(std::uint32_t threads) {
+    using Stats = IsrProfileStats<I, HostTimeSource>;
+    auto const ns
+      = nsPerCall(threads, 2'000'000 / threads, [](std::uint32_t i) { Stats::record(i, i + (i & 63)); });
+    std::print("  record  {} thread(s): {:7.2f} ns/call\n", threads, ns);
+}
+
+template<int I>
+static void benchOnIsr(std::uint32_t threads) {
+    using W = IsrProfileWrapper<emptyIsr, Index<I>, HostTimeSource>;
+    auto const ns = nsPerCall(threads, 2'000'000 / threads, [](std::uint32_t) { W::onIsr(); });
+    std::print("  onIsr   {} thread(s): {:7.2f} ns/call\n", threads, ns);
+}
+
+static void benchTimeSource() {
+    auto const ns = nsPerCall(1, 2'000'000, [](std::uint32_t) {
+        [[maybe_unused]] auto volatile t = HostTimeSource::now();
+    });
+    std::print("  HostTimeSource::now:   {:7.2f} ns/call\n", ns);
+}
+
+int main() {
+    std::print("ISR profiler per-call cost\n");
+    benchTimeSource();
+    benchRecord<0>(1);
+    benchRecord<1>(2);
+    benchRecord<2>(4);
+    benchOnIsr<3>(1);
+    benchOnIsr<4>(4);
+    return 0;
+}
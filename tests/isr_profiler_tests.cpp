@@ -0,0 +1,342 @@
+// Tests for the ISR profiler statistics, driven by a deterministic virtual clock and by
+// several host threads calling IsrProfileWrapper::onIsr concurrently.
+#include "kvasir_test.hpp"
+
+#include "kvasir/StartUp/IsrProfiler.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <print>
+#include <thread>
+#include <vector>
+
+using namespace Kvasir::Test;
+using namespace Kvasir::Startup;
+using Kvasir::Nvic::Index;
+
+// time only advances when a test says so
+struct VirtualClock {
+    static inline std::uint32_t time{};
+
+    static std::uint32_t now() noexcept { return time; }
+
+    static void advance(std::uint32_t cycles) noexcept { time += cycles; }
+};
+
+// simulated ISR bodies, the duration is the time the body advances the clock
+static std::uint32_t isrBodyCycles{};
+
+static void virtualIsr() { VirtualClock::advance(isrBodyCycles); }
+
+static std::atomic<std::uint32_t> hostIsrCalls{};
+
+static void hostIsr() { hostIsrCalls.fetch_add(1, std::memory_order_relaxed); }
+
+static void intervalsAndDurations() {
+    test("intervalsAndDurations");
+
+    using W = IsrProfileWrapper<virtualIsr, Index<1>, VirtualClock>;
+
+    VirtualClock::time = 1000;
+    isrBodyCycles      = 10;
+    W::onIsr();   // enter 1000, no interval yet
+
+    VirtualClock::advance(90);
+    isrBodyCycles = 30;
+    W::onIsr();   // enter 1100, interval 100
+
+    VirtualClock::advance(270);
+    isrBodyCycles = 20;
+    W::onIsr();   // enter 1400, interval 300
+
+    auto const s = W::Stats::snapshot();
+    CHECK_EQ(s.isrIndex, 1);
+    CHECK_EQ(s.callCount, 3u);
+    CHECK_EQ(s.minIntervalCycles, 100u);
+    CHECK_EQ(s.maxIntervalCycles, 300u);
+    CHECK_EQ(s.avgIntervalCycles, 200u);
+    CHECK_EQ(s.lastCallTime, 1400u);
+    CHECK_EQ(s.minDurationCycles, 10u);
+    CHECK_EQ(s.maxDurationCycles, 30u);
+    CHECK_EQ(s.avgDurationCycles, 20u);
+    CHECK_EQ(s.latencyCount, 0u);
+}
+
+// the first call must not produce an interval, even at timestamp 0
+static void firstCallAtZero() {
+    test("firstCallAtZero");
+
+    using W = IsrProfileWrapper<virtualIsr, Index<2>, VirtualClock>;
+
+    VirtualClock::time = 0;
+    isrBodyCycles      = 0;
+    W::onIsr();
+
+    auto const s = W::Stats::snapshot();
+    CHECK_EQ(s.callCount, 1u);
+    CHECK_EQ(s.maxIntervalCycles, 0u);
+    CHECK_EQ(s.avgIntervalCycles, 0u);
+    CHECK_EQ(s.minDurationCycles, 0u);
+}
+
+// intervals and durations across the 32 bit wrap of the time source
+static void timestampWrap() {
+    test("timestampWrap");
+
+    using W = IsrProfileWrapper<virtualIsr, Index<3>, VirtualClock>;
+
+    VirtualClock::time = 0xFFFFFF00;
+    isrBodyCycles      = 0x200;   // exits after the wrap
+    W::onIsr();
+
+    VirtualClock::advance(0x100);
+    W::onIsr();
+
+    auto const s = W::Stats::snapshot();
+    CHECK_EQ(s.minDurationCycles, 0x200u);
+    CHECK_EQ(s.maxDurationCycles, 0x200u);
+    CHECK_EQ(s.minIntervalCycles, 0x300u);
+    CHECK_EQ(s.lastCallTime, 0x200u);
+}
+
+struct FixedEventTime {
+    static inline std::uint32_t time{};
+
+    static std::uint32_t eventTime() noexcept { return time; }
+};
+
+static void latency() {
+    test("latency");
+
+    using Policy = LatencyPolicy<ProfileAllPolicy, LatencySource<Index<4>{}, FixedEventTime>>;
+    using W      = IsrProfileWrapper<virtualIsr, Index<4>, VirtualClock, Policy>;
+    using Plain  = IsrProfileWrapper<virtualIsr, Index<5>, VirtualClock, Policy>;
+
+    isrBodyCycles = 5;
+
+    FixedEventTime::time = 100;
+    VirtualClock::time   = 112;
+    W::onIsr();
+
+    FixedEventTime::time = 1000;
+    VirtualClock::time   = 1020;
+    W::onIsr();
+
+    Plain::onIsr();
+
+    auto const s = W::Stats::snapshot();
+    CHECK_EQ(s.latencyCount, 2u);
+    CHECK_EQ(s.minLatencyCycles, 12u);
+    CHECK_EQ(s.maxLatencyCycles, 20u);
+    CHECK_EQ(s.avgLatencyCycles, 16u);
+
+    CHECK_EQ(Plain::Stats::snapshot().latencyCount, 0u);
+}
+
+struct MissRecorder {
+    static inline std::vector<DeadlineViolation> misses;
+
+    static void onDeadlineMiss(DeadlineViolation const& v) { misses.push_back(v); }
+};
+
+static void deadlines() {
+    test("deadlines");
+
+    using Budget   = DeadlineBudget<Index<11>{}, 50>;
+    using Policy   = DeadlinePolicy<ProfileAllPolicy, MissRecorder, Budget>;
+    using W        = IsrProfileWrapper<virtualIsr, Index<11>, VirtualClock, Policy>;
+    using NoBudget = IsrProfileWrapper<virtualIsr, Index<12>, VirtualClock, Policy>;
+
+    MissRecorder::misses.clear();
+
+    VirtualClock::time = 100;
+    isrBodyCycles      = 50;   // exactly on budget
+    W::onIsr();
+    CHECK(MissRecorder::misses.empty());
+
+    VirtualClock::time = 1000;
+    isrBodyCycles      = 80;
+    W::onIsr();
+
+    VirtualClock::time = 2000;
+    isrBodyCycles      = 60;
+    W::onIsr();
+
+    NoBudget::onIsr();
+
+    auto const s = W::Stats::snapshot();
+    CHECK_EQ(s.callCount, 3u);
+    CHECK_EQ(s.deadlineViolations, 2u);
+    CHECK_EQ(s.worstOverrunCycles, 30u);
+    CHECK_EQ(s.worstOverrunTime, 1000u);
+    CHECK_EQ(NoBudget::Stats::snapshot().deadlineViolations, 0u);
+
+    // the host calls the hook directly
+    CHECK_EQ(MissRecorder::misses.size(), 2u);
+    if(MissRecorder::misses.size() == 2) {
+        auto const& v = MissRecorder::misses[0];
+        CHECK_EQ(v.isrIndex, 11);
+        CHECK_EQ(v.enter, 1000u);
+        CHECK_EQ(v.duration, 80u);
+        CHECK_EQ(v.budget, 50u);
+        CHECK_EQ(v.missed, 1u);
+        CHECK_EQ(MissRecorder::misses[1].duration, 60u);
+    }
+}
+
+static void traceRecords() {
+    test("traceRecords");
+
+    using W = IsrProfileWrapper<virtualIsr, Index<6>, VirtualClock, TraceEventsPolicy<ProfileAllPolicy>>;
+
+    isrTraceBuffer.stop();
+    isrTraceBuffer.clear();
+    isrTraceBuffer.start();
+
+    VirtualClock::time = 500;
+    isrBodyCycles      = 7;
+    W::onIsr();
+    isrTraceBuffer.mark<VirtualClock>(9);
+    isrTraceBuffer.stop();
+    W::onIsr();   // not recorded while stopped
+
+    CHECK_EQ(isrTraceBuffer.size(), 2u);
+    auto const& r = isrTraceBuffer.records[0];
+    CHECK(r.kind == IsrTraceKind::isr);
+    CHECK_EQ(r.id, 6);
+    CHECK_EQ(r.enter, 500u);
+    CHECK_EQ(r.exit, 507u);
+    auto const& m = isrTraceBuffer.records[1];
+    CHECK(m.kind == IsrTraceKind::marker);
+    CHECK_EQ(m.id, 9);
+    CHECK_EQ(m.enter, 507u);
+}
+
+static void loadMonitor() {
+    test("loadMonitor");
+
+    using A       = IsrProfileWrapper<virtualIsr, Index<7>, VirtualClock>;
+    using B       = IsrProfileWrapper<virtualIsr, Index<8>, VirtualClock>;
+    using Monitor = IsrLoadMonitor<VirtualClock, brigand::list<A, B>, 2>;
+
+    VirtualClock::time = 0;
+    Monitor::sample();   // starts the first window
+
+    // window 1: 1000 cycles, A busy 100, B busy 50
+    isrBodyCycles = 100;
+    A::onIsr();
+    isrBodyCycles = 50;
+    B::onIsr();
+    VirtualClock::advance(850);
+    Monitor::sample();
+
+    auto s = Monitor::cpuLoad();
+    CHECK_EQ(s.cycles, 1000u);
+    CHECK_EQ(s.isrIndex[0], 7);
+    CHECK_EQ(s.isrIndex[1], 8);
+    CHECK_EQ(s.perIsrPermille[0], 100u);
+    CHECK_EQ(s.perIsrPermille[1], 50u);
+    CHECK_EQ(s.isrPermille, 150u);
+    CHECK_EQ(s.mainPermille, 850u);
+    CHECK_EQ(s.peakIsrPermille, 150u);
+
+    // window 2: 1000 cycles idle, summed over both windows
+    VirtualClock::advance(1000);
+    Monitor::sample();
+    s = Monitor::cpuLoad();
+    CHECK_EQ(s.cycles, 2000u);
+    CHECK_EQ(s.isrPermille, 75u);
+    CHECK_EQ(s.peakIsrPermille, 150u);
+
+    // window 3 replaces window 1
+    isrBodyCycles = 500;
+    A::onIsr();
+    VirtualClock::advance(500);
+    Monitor::sample();
+    s = Monitor::cpuLoad();
+    CHECK_EQ(s.cycles, 2000u);
+    CHECK_EQ(s.perIsrPermille[0], 250u);
+    CHECK_EQ(s.perIsrPermille[1], 0u);
+    CHECK_EQ(Monitor::peakLoad(), 500u);
+
+    Monitor::resetPeak();
+    CHECK_EQ(Monitor::peakLoad(), 0u);
+}
+
+// several threads standing in for nested ISRs of different priorities, all hitting
+// the same statistics
+static void concurrentRecords() {
+    test("concurrentRecords");
+
+    using W = IsrProfileWrapper<hostIsr, Index<9>, HostTimeSource>;
+
+    constexpr std::uint32_t threads   = 8;
+    constexpr std::uint32_t perThread = 20000;
+
+    std::atomic<bool>        go{false};
+    std::vector<std::thread> workers;
+    for(std::uint32_t t = 0; t != threads; ++t) {
+        workers.emplace_back([&go] {
+            while(!go.load(std::memory_order_acquire)) {}
+            for(std::uint32_t i = 0; i != perThread; ++i) { W::onIsr(); }
+        });
+    }
+    go.store(true, std::memory_order_release);
+    for(auto& w : workers) { w.join(); }
+
+    auto const s = W::Stats::snapshot();
+    CHECK_EQ(hostIsrCalls.load(), threads * perThread);
+    CHECK_EQ(s.callCount, threads * perThread);
+    CHECK(s.minDurationCycles <= s.avgDurationCycles);
+    CHECK(s.avgDurationCycles <= s.maxDurationCycles);
+    CHECK(s.minIntervalCycles <= s.maxIntervalCycles);
+    // every duration was added exactly once
+    CHECK(W::Stats::duration.total.load() >= std::uint64_t{s.minDurationCycles} * s.callCount);
+    CHECK(W::Stats::duration.total.load() <= std::uint64_t{s.maxDurationCycles} * s.callCount);
+}
+
+// concurrent deterministic durations: min/max must be exact regardless of interleaving
+static void concurrentMinMax() {
+    test("concurrentMinMax");
+
+    using Stats = IsrProfileStats<10, VirtualClock>;
+
+    constexpr std::uint32_t threads   = 8;
+    constexpr std::uint32_t perThread = 10000;
+
+    std::vector<std::thread> workers;
+    for(std::uint32_t t = 0; t != threads; ++t) {
+        workers.emplace_back([t] {
+            for(std::uint32_t i = 0; i != perThread; ++i) {
+                std::uint32_t const d = 100 + ((i * threads + t) % 1000);
+                Stats::record(0, d);
+            }
+        });
+    }
+    for(auto& w : workers) { w.join(); }
+
+    auto const s = Stats::snapshot();
+    CHECK_EQ(s.callCount, threads * perThread);
+    CHECK_EQ(s.minDurationCycles, 100u);
+    CHECK_EQ(s.maxDurationCycles, 1099u);
+    // each duration 100..1099 occurs equally often
+    CHECK_EQ(Stats::duration.total.load(), std::uint64_t{threads * perThread / 1000} * 599500u);
+}
+
+int main() {
+    intervalsAndDurations();
+    firstCallAtZero();
+    timestampWrap();
+    latency();
+    deadlines();
+    traceRecords();
+    loadMonitor();
+    concurrentRecords();
+    concurrentMinMax();
+
+    if(Kvasir::Test::failures != 0) {
+        std::print("{} checks failed\n", Kvasir::Test::failures);
+        return 1;
+    }
+    return 0;
+}
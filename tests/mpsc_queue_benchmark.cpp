@@ -0,0 +1,90 @@
+// Benchmark of Atomic::MpscQueue throughput: host threads as producers feeding one
+// consumer, with OrderingPolicyMultiCore, compared against a std::mutex protected
+// ring. Not run by ctest, build and run kvasir_benchmark_mpsc_queue manually (in a
+// Release build).
+#include "kvasir/Atomic/MpscQueue.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <print>
+#include <thread>
+#include <vector>
+
+using Kvasir::Atomic::MpscQueue;
+using Kvasir::Atomic::OrderingPolicyMultiCore;
+using Kvasir::Atomic::OverFlowPolicyIgnore;
+
+template<std::size_t Size>
+struct MutexQueue {
+    std::mutex                      m;
+    std::array<std::uint64_t, Size> data{};
+    std::size_t                     head{};
+    std::size_t                     tail{};
+
+    bool try_push(std::uint64_t v) {
+        std::lock_guard l{m};
+        if(tail - head == Size) { return false; }
+        data[tail++ % Size] = v;
+        return true;
+    }
+
+    bool pop_into(std::uint64_t& v) {
+        std::lock_guard l{m};
+        if(tail == head) { return false; }
+        v = data[head++ % Size];
+        return true;
+    }
+};
+
+template<typename Q>
+static double itemsPerUs(Q&            q,
+                         std::uint32_t producers,
+                         std::uint32_t perProducer) {
+    std::atomic<bool>        go{false};
+    std::vector<std::thread> threads;
+    for(std::uint32_t p = 0; p != producers; ++p) {
+        threads.emplace_back([&q, &go, perProducer] {
+            while(!go.load(std::memory_order_acquire)) {}
+            for(std::uint32_t i = 0; i != perProducer; ++i) {
+                while(!q.try_push(i)) { std::this_thread::yield(); }
+            }
+        });
+    }
+    auto const start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    std::uint64_t const total = std::uint64_t{producers} * perProducer;
+    std::uint64_t       received{};
+    std::uint64_t       v{};
+    while(received != total) {
+        if(q.pop_into(v)) {
+            ++received;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    for(auto& t : threads) { t.join(); }
+    return static_cast<double>(total) / std::chrono::duration<double, std::micro>(elapsed).count();
+}
+
+static void bench(std::uint32_t producers) {
+    static MpscQueue<std::uint64_t, 1024, OverFlowPolicyIgnore, OrderingPolicyMultiCore> mpsc{};
+    static MutexQueue<1024>                                                                mutex{};
+    auto const lockFree = itemsPerUs(mpsc, producers, 1'000'000 / producers);
+    auto const locked   = itemsPerUs(mutex, producers, 1'000'000 / producers);
+    std::print("  {} producer(s): MpscQueue {:7.2f} items/us, mutex ring {:7.2f} items/us\n",
+               producers,
+               lockFree,
+               locked);
+}
+
+int main() {
+    std::print("MpscQueue throughput, 1 consumer\n");
+    bench(1);
+    bench(2);
+    bench(4);
+    return 0;
+}
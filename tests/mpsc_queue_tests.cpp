@@ -0,0 +1,121 @@
+// Tests for Atomic::MpscQueue: ordering, full and wrap handling single threaded, and a
+// stress test with host threads as producers (OrderingPolicyMultiCore).
+#include "kvasir_test.hpp"
+
+#include "kvasir/Atomic/MpscQueue.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <print>
+#include <thread>
+#include <vector>
+
+using namespace Kvasir::Test;
+using Kvasir::Atomic::MpscQueue;
+using Kvasir::Atomic::OrderingPolicyMultiCore;
+
+static std::uint32_t overflows{};
+
+struct CountOverflow {
+    void operator()() { ++overflows; }
+};
+
+static void fifoAndFull() {
+    test("fifoAndFull");
+
+    static MpscQueue<std::uint32_t, 4, CountOverflow> q{};
+    CHECK(q.empty());
+    CHECK_EQ(q.max_size(), 4u);
+
+    for(std::uint32_t i = 0; i != 4; ++i) { CHECK(q.try_push(i)); }
+    CHECK_EQ(q.size(), 4u);
+    CHECK(!q.try_push(4));
+    q.push(4);
+    CHECK_EQ(overflows, 1u);
+
+    std::uint32_t v{};
+    for(std::uint32_t i = 0; i != 4; ++i) {
+        CHECK(q.pop_into(v));
+        CHECK_EQ(v, i);
+    }
+    CHECK(q.empty());
+    CHECK(!q.pop_into(v));
+}
+
+static void wrap() {
+    test("wrap");
+
+    MpscQueue<std::uint16_t, 8> q{};
+    std::uint16_t               in{};
+    std::uint16_t               out{};
+    bool                        inOrder = true;
+    // many times around the ring, with a varying fill level
+    for(std::uint32_t round = 0; round != 1000; ++round) {
+        for(std::uint32_t i = 0; i != round % 8 + 1; ++i) { q.push(in++); }
+        std::uint16_t v{};
+        while(q.pop_into(v)) { inOrder = inOrder && v == out++; }
+    }
+    CHECK(inOrder);
+    CHECK_EQ(in, out);
+    CHECK_EQ(q.size(), 0u);
+}
+
+// every producer pushes its id and a running number, the consumer checks that each
+// producer's items arrive complete and in order
+static void concurrentProducers() {
+    test("concurrentProducers");
+
+    constexpr std::uint32_t producers   = 4;
+    constexpr std::uint32_t perProducer = 100000;
+
+    struct Item {
+        std::uint32_t producer;
+        std::uint32_t number;
+    };
+
+    static MpscQueue<Item, 64, CountOverflow, OrderingPolicyMultiCore> q{};
+
+    std::vector<std::thread> threads;
+    for(std::uint32_t p = 0; p != producers; ++p) {
+        threads.emplace_back([p]() {
+            for(std::uint32_t i = 0; i != perProducer; ++i) {
+                while(!q.try_push(Item{p, i})) { std::this_thread::yield(); }
+            }
+        });
+    }
+
+    std::array<std::uint32_t, producers> next{};
+    std::uint32_t                        outOfOrder{};
+    std::uint32_t                        received{};
+    while(received != producers * perProducer) {
+        Item item{};
+        if(!q.pop_into(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if(item.producer >= producers || item.number != next[item.producer]) {
+            ++outOfOrder;
+        } else {
+            ++next[item.producer];
+        }
+        ++received;
+    }
+    for(auto& t : threads) { t.join(); }
+
+    CHECK_EQ(outOfOrder, 0u);
+    for(auto n : next) { CHECK_EQ(n, perProducer); }
+    CHECK(q.empty());
+}
+
+int main() {
+    fifoAndFull();
+    wrap();
+    concurrentProducers();
+
+    if(Kvasir::Test::failures != 0) {
+        std::print("{} checks failed\n", Kvasir::Test::failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+// Tests for the PC sample table of PcSampler: bucketing of (pc, lr) pairs, probing on
+// collisions and the bounded behaviour once the table is full.
+#include "kvasir_test.hpp"
+
+#include "kvasir/StartUp/PcSampler.hpp"
+
+#include <cstdint>
+#include <print>
+
+using namespace Kvasir::Test;
+using namespace Kvasir::Startup;
+
+template<std::size_t Buckets>
+static std::uint32_t countOf(PcSampleTable<Buckets> const& t,
+                             std::uint32_t                 pc,
+                             std::uint32_t                 lr) {
+    for(auto const& b : t.buckets) {
+        if(b.pc == pc && b.lr == lr) { return b.count; }
+    }
+    return 0;
+}
+
+template<std::size_t Buckets>
+static std::uint32_t usedBuckets(PcSampleTable<Buckets> const& t) {
+    std::uint32_t n{};
+    for(auto const& b : t.buckets) {
+        if(b.pc != 0) { ++n; }
+    }
+    return n;
+}
+
+static void countsPairs() {
+    test("countsPairs");
+
+    static PcSampleTable<64> t{};
+    t.add(0x08001000, 0x08000200);
+    t.add(0x08001000, 0x08000200);
+    t.add(0x08001000, 0x08000300);   // same pc, other caller
+    t.add(0x08001004, 0x08000200);
+
+    CHECK_EQ(t.samples, 4u);
+    CHECK_EQ(t.dropped, 0u);
+    CHECK_EQ(countOf(t, 0x08001000, 0x08000200), 2u);
+    CHECK_EQ(countOf(t, 0x08001000, 0x08000300), 1u);
+    CHECK_EQ(countOf(t, 0x08001004, 0x08000200), 1u);
+    CHECK_EQ(usedBuckets(t), 3u);
+}
+
+// fill far beyond the capacity: every sample is either counted or dropped
+static void fullTable() {
+    test("fullTable");
+
+    static PcSampleTable<16> t{};
+    for(std::uint32_t i = 0; i != 100; ++i) {
+        for(std::uint32_t r = 0; r != 3; ++r) { t.add(0x08000000 + i * 2, 0x08010000); }
+    }
+
+    std::uint32_t counted{};
+    for(auto const& b : t.buckets) { counted += b.count; }
+    CHECK_EQ(t.samples, 300u);
+    CHECK_EQ(usedBuckets(t), 16u);
+    CHECK_EQ(counted + t.dropped, 300u);
+    CHECK_EQ(counted, 16u * 3u);
+}
+
+static void stopAndClear() {
+    test("stopAndClear");
+
+    static PcSampleTable<16> t{};
+    t.add(0x100, 0x200);
+    t.stop();
+    t.add(0x100, 0x200);
+    CHECK_EQ(t.samples, 1u);
+    CHECK_EQ(countOf(t, 0x100, 0x200), 1u);
+
+    t.clear();
+    t.start();
+    CHECK_EQ(usedBuckets(t), 0u);
+    t.add(0x104, 0x200);
+    CHECK_EQ(t.samples, 1u);
+    CHECK_EQ(countOf(t, 0x104, 0x200), 1u);
+}
+
+// PcSampler::sample() takes pc and lr (without the thumb bit) from the exception frame
+static void sampleFromFrame() {
+    test("sampleFromFrame");
+
+    static PcSampleTable<32> t{};
+    std::uint32_t const      frame[8]{0, 1, 2, 3, 12, 0x08000451, 0x08000600, 0x01000000};
+    t.addFrame(frame);
+    t.addFrame(frame);
+
+    CHECK_EQ(t.samples, 2u);
+    CHECK_EQ(countOf(t, 0x08000600, 0x08000450), 2u);
+}
+
+int main() {
+    countsPairs();
+    fullTable();
+    stopAndClear();
+    sampleFromFrame();
+
+    if(Kvasir::Test::failures != 0) {
+        std::print("{} checks failed\n", Kvasir::Test::failures);
+        return 1;
+    }
+    return 0;
+}
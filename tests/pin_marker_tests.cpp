@@ -0,0 +1,123 @@
+// Tests for PinMarkerPolicy: the pin writes around IsrProfileWrapper::onIsr and the
+// binary ISR code, on a mock BSRR style set/reset register.
+#include "kvasir_test.hpp"
+
+#include "kvasir/StartUp/IsrProfiler.hpp"
+
+#include <cstdint>
+#include <print>
+
+using namespace Kvasir::Test;
+using namespace Kvasir::Startup;
+using Kvasir::Nvic::Index;
+using W = Recorder::Write;
+
+// set/reset register: bits 0..15 set pins 0..15, bits 16..31 clear them, zero bits are
+// ignored so no read-modify-write is needed
+using MarkerBsrr = Kvasir::Register::Address<0x40, 0xFFFFFFFF, 0x00000000, std::uint32_t>;
+
+template<unsigned Bit>
+using MarkerBit = Kvasir::Register::FieldLocation<MarkerBsrr,
+                                                  Kvasir::Register::maskFromRange(Bit, Bit),
+                                                  Kvasir::Register::WriteOnlyAccess,
+                                                  std::uint32_t>;
+
+template<unsigned Bit>
+using MarkerWrite = decltype(write(MarkerBit<Bit>{}, Kvasir::Register::value<std::uint32_t, 1>()));
+
+// what a chip file provides for port 0
+namespace Kvasir { namespace Io {
+    template<int Pin>
+    struct MakeAction<Action::Set, Register::PinLocation<0, Pin>> {
+        using type = MarkerWrite<Pin>;
+    };
+
+    template<int Pin>
+    struct MakeAction<Action::Clear, Register::PinLocation<0, Pin>> {
+        using type = MarkerWrite<Pin + 16>;
+    };
+}}   // namespace Kvasir::Io
+
+static constexpr auto pin2 = Kvasir::Io::makePinLocation(Kvasir::Io::port0, Kvasir::Io::pin2);
+static constexpr auto pin3 = Kvasir::Io::makePinLocation(Kvasir::Io::port0, Kvasir::Io::pin3);
+
+struct TickClock {
+    static inline std::uint32_t time{};
+
+    static std::uint32_t now() noexcept { return time++; }
+};
+
+static void isrBody() { recorder.actions.emplace_back(W{0xAA, 0}); }
+
+static void singlePin() {
+    test("singlePin");
+
+    using Policy = PinMarkerPolicy<ProfileAllPolicy, MarkerPins<pin2>>;
+    using Wrap   = IsrProfileWrapper<isrBody, Index<20>, TickClock, Policy>;
+
+    Wrap::onIsr();
+
+    checkActions({
+      W{MarkerBsrr::value, 1U << 2},
+      W{0xAA, 0},
+      W{MarkerBsrr::value, 1U << 18}
+    });
+    CHECK_EQ(Wrap::Stats::snapshot().callCount, 1u);
+}
+
+// each ISR writes its code with one write, set and clear bits together
+static void binaryCode() {
+    test("binaryCode");
+
+    using Policy = PinMarkerPolicy<ProfileAllPolicy,
+                                   MarkerPins<pin2, pin3>,
+                                   Index<21>{},
+                                   Index<22>{},
+                                   Index<23>{}>;
+    using First  = IsrProfileWrapper<isrBody, Index<21>, TickClock, Policy>;
+    using Second = IsrProfileWrapper<isrBody, Index<22>, TickClock, Policy>;
+    using Third  = IsrProfileWrapper<isrBody, Index<23>, TickClock, Policy>;
+    using Other  = IsrProfileWrapper<isrBody, Index<24>, TickClock, Policy>;
+
+    First::onIsr();
+    checkActions({
+      W{MarkerBsrr::value, (1U << 2) | (1U << 19)},
+      W{0xAA, 0},
+      W{MarkerBsrr::value, (1U << 18) | (1U << 19)}
+    });
+
+    recorder.reset();
+    Second::onIsr();
+    checkActions({
+      W{MarkerBsrr::value, (1U << 18) | (1U << 3)},
+      W{0xAA, 0},
+      W{MarkerBsrr::value, (1U << 18) | (1U << 19)}
+    });
+
+    recorder.reset();
+    Third::onIsr();
+    checkActions({
+      W{MarkerBsrr::value, (1U << 2) | (1U << 3)},
+      W{0xAA, 0},
+      W{MarkerBsrr::value, (1U << 18) | (1U << 19)}
+    });
+
+    // not listed: profiled but not marked
+    recorder.reset();
+    Other::onIsr();
+    checkActions({
+      W{0xAA, 0}
+    });
+    CHECK_EQ(Other::Stats::snapshot().callCount, 1u);
+}
+
+int main() {
+    singlePin();
+    binaryCode();
+
+    if(Kvasir::Test::failures != 0) {
+        std::print("{} checks failed\n", Kvasir::Test::failures);
+        return 1;
+    }
+    return 0;
+}
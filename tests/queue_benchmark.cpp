@@ -0,0 +1,140 @@
+// Benchmark of the Atomic::Queue range operations: bytes per ns of push(range) plus
+// pop_into(range) for byte queues of UART/ADC buffer sizes, compared against the
+// previous element wise copy through a modulo index (ReferenceQueue), and the cross
+// thread throughput with OrderingPolicyMultiCore. Not run by ctest, build and run
+// kvasir_benchmark_queue manually (in a Release build).
+#include "kvasir/Atomic/Queue.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <print>
+#include <thread>
+
+using Kvasir::Atomic::OrderingPolicyMultiCore;
+using Kvasir::Atomic::OverFlowPolicyIgnore;
+using Kvasir::Atomic::Queue;
+
+// the range operations as they were before the two segment copy
+template<typename T, std::size_t Size>
+struct ReferenceQueue {
+    std::atomic<std::uint32_t> head_{};
+    std::atomic<std::uint32_t> tail_{};
+    std::array<T, Size>        data_{};
+
+    static std::uint32_t next(std::uint32_t in) { return (in + 1) % Size; }
+
+    static std::uint32_t distance(std::uint32_t head,
+                                  std::uint32_t tail) {
+        auto d = int(tail - head);
+        if(d < 0) { d += Size; }
+        return std::uint32_t(d);
+    }
+
+    template<typename TRange>
+    void push(TRange const& range) {
+        auto       tail = tail_.load(std::memory_order_relaxed);
+        auto const head = head_.load(std::memory_order_relaxed);
+        if(range.size() < Size - distance(head, tail)) {
+            for(auto const& v : range) {
+                data_[tail] = v;
+                tail        = next(tail);
+            }
+            std::atomic_signal_fence(std::memory_order_release);
+            tail_.store(tail, std::memory_order_relaxed);
+        }
+    }
+
+    template<typename TRange>
+    bool pop_into(TRange& range) {
+        auto const tail = tail_.load(std::memory_order_relaxed);
+        auto       head = head_.load(std::memory_order_relaxed);
+        if(distance(head, tail) < range.size()) { return false; }
+        for(auto& v : range) {
+            v    = data_[head];
+            head = next(head);
+        }
+        std::atomic_signal_fence(std::memory_order_release);
+        head_.store(head, std::memory_order_relaxed);
+        return true;
+    }
+};
+
+template<typename Q,
+         std::size_t Chunk>
+static double bytesPerNs(Q& q) {
+    constexpr std::size_t           rounds = 20'000'000 / Chunk;
+    std::array<std::uint8_t, Chunk> in{};
+    std::array<std::uint8_t, Chunk> out{};
+    std::uint64_t                   check{};
+
+    auto const start = std::chrono::steady_clock::now();
+    for(std::size_t i = 0; i != rounds; ++i) {
+        in[0] = static_cast<std::uint8_t>(i);
+        q.push(in);
+        q.pop_into(out);
+        check += out[0];
+    }
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    [[maybe_unused]] auto volatile keep = check;
+    return static_cast<double>(rounds * Chunk)
+         / std::chrono::duration<double, std::nano>(elapsed).count();
+}
+
+template<std::size_t Size,
+         std::size_t Chunk>
+static void bench() {
+    static ReferenceQueue<std::uint8_t, Size>              reference{};
+    static Queue<std::uint8_t, Size, OverFlowPolicyIgnore> queue{};
+    auto const before = bytesPerNs<decltype(reference), Chunk>(reference);
+    auto const after  = bytesPerNs<decltype(queue), Chunk>(queue);
+    std::print("  Size {:5} chunk {:4}: {:7.3f} -> {:7.3f} bytes/ns ({:5.1f}x)\n",
+               Size,
+               Chunk,
+               before,
+               after,
+               after / before);
+}
+
+// producer and consumer thread, Chunk elements per push/pop_into
+template<std::size_t Chunk>
+static void benchThreads() {
+    static Queue<std::uint32_t, 1024, OverFlowPolicyIgnore, OrderingPolicyMultiCore> q{};
+
+    constexpr std::uint32_t count = 10'000'000 / Chunk * Chunk;
+    auto const              start = std::chrono::steady_clock::now();
+    std::thread             producer{[]() {
+        std::array<std::uint32_t, Chunk> chunk{};
+        for(std::uint32_t i = 0; i != count; i += Chunk) {
+            while(q.reserve(Chunk).size() != Chunk) { std::this_thread::yield(); }
+            chunk[0] = i;
+            q.push(chunk);
+        }
+    }};
+    std::array<std::uint32_t, Chunk> out{};
+    for(std::uint32_t i = 0; i != count; i += Chunk) {
+        while(!q.pop_into(out)) { std::this_thread::yield(); }
+    }
+    producer.join();
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    std::print("  chunk {:4}: {:7.2f} elements/us\n",
+               Chunk,
+               count / std::chrono::duration<double, std::micro>(elapsed).count());
+}
+
+int main() {
+    std::print("Queue push(range) + pop_into(range), element wise modulo -> two segment copy\n");
+    bench<1024, 17>();
+    bench<1024, 256>();
+    bench<4096, 64>();
+    bench<4096, 1000>();
+    bench<1000, 64>();   // not a power of two
+    bench<3000, 1000>();
+    std::print("Queue<std::uint32_t, 1024> producer and consumer thread, OrderingPolicyMultiCore\n");
+    benchThreads<1>();
+    benchThreads<16>();
+    benchThreads<256>();
+    return 0;
+}
@@ -0,0 +1,164 @@
+// Tests for OverFlowPolicyStats: push, overflow and high water accounting of single
+// element, range and reserve/commit pushes, statistics per capacity, front() of an
+// empty queue and the link-time registry.
+#include "kvasir_test.hpp"
+
+#include "kvasir/Atomic/Queue.hpp"
+#include "kvasir/Atomic/QueueStats.hpp"
+
+#include <array>
+#include <cstdint>
+#include <print>
+#include <stdexcept>
+
+using namespace Kvasir::Test;
+using namespace Kvasir::Atomic;
+
+using RxStats = OverFlowPolicyStats<"rx">;
+using TxStats = OverFlowPolicyStats<"tx">;
+
+static void counters() {
+    test("counters");
+
+    Queue<std::uint8_t, 8, RxStats> q{};
+    auto const&                     s = RxStats::stats<7>();
+    CHECK_EQ(s.pushes.load(), 0u);
+
+    q.push(1);
+    q.push(2);
+    q.push(3);
+    q.pop();
+    q.push(4);
+    CHECK_EQ(s.pushes.load(), 4u);
+    CHECK_EQ(s.highWater.load(), 3u);
+    CHECK_EQ(s.overflows.load(), 0u);
+
+    // fill up, then one more
+    for(std::uint8_t i = 0; i != 4; ++i) { q.push(i); }
+    CHECK_EQ(q.size(), q.max_size());
+    q.push(9);
+    CHECK_EQ(s.overflows.load(), 1u);
+    CHECK_EQ(s.pushes.load(), 8u);
+    CHECK_EQ(s.highWater.load(), 7u);
+
+    // draining does not lower the high water mark
+    std::uint8_t v{};
+    while(q.pop_into(v)) {}
+    q.push(1);
+    CHECK_EQ(s.highWater.load(), 7u);
+    CHECK_EQ(s.pushes.load(), 9u);
+}
+
+static void rangesAndCommit() {
+    test("rangesAndCommit");
+
+    Queue<std::uint32_t, 16, TxStats> q{};
+    auto const&                       s = TxStats::stats<15>();
+
+    std::array<std::uint32_t, 5> five{};
+    q.push(five);
+    CHECK_EQ(s.pushes.load(), 5u);
+    CHECK_EQ(s.highWater.load(), 5u);
+
+    auto const slots = q.reserve(4);
+    CHECK_EQ(slots.size(), 4u);
+    q.commit(3);
+    CHECK_EQ(s.pushes.load(), 8u);
+    CHECK_EQ(s.highWater.load(), 8u);
+
+    std::array<std::uint32_t, 8> tooMany{};
+    q.push(tooMany);   // 8 + 8 > max_size()
+    CHECK_EQ(s.overflows.load(), 1u);
+    CHECK_EQ(s.pushes.load(), 8u);
+}
+
+// a name reused for a queue of another size does not mix the counters
+static void perCapacity() {
+    test("perCapacity");
+
+    Queue<std::uint8_t, 4, RxStats> small{};
+    small.push(1);
+    small.push(2);
+    small.push(3);
+    small.push(4);   // overflow
+
+    auto const& s = RxStats::stats<3>();
+    CHECK(&s != &RxStats::stats<7>());
+    CHECK_EQ(s.pushes.load(), 3u);
+    CHECK_EQ(s.overflows.load(), 1u);
+    CHECK_EQ(s.highWater.load(), 3u);
+    // untouched by the counters test
+    CHECK_EQ(RxStats::stats<7>().pushes.load(), 9u);
+    CHECK_EQ(RxStats::stats<7>().overflows.load(), 1u);
+}
+
+struct OverFlowPolicyThrow {
+    void operator()() { throw std::underflow_error{"empty"}; }
+};
+
+// front() of an empty queue goes to the wrapped policy without counting an overflow
+static void underflow() {
+    test("underflow");
+
+    using Stats = OverFlowPolicyStats<"underflow", OverFlowPolicyThrow>;
+    Queue<std::uint8_t, 8, Stats> q{};
+    bool                          thrown{};
+    try {
+        (void)q.front();
+    } catch(std::underflow_error const&) { thrown = true; }
+    CHECK(thrown);
+    CHECK_EQ(Stats::stats<7>().overflows.load(), 0u);
+
+    q.push(5);
+    CHECK_EQ(q.front(), 5);
+}
+
+// the statistics live in the policy, the queue does not grow
+static_assert(sizeof(Queue<std::uint8_t, 16, RxStats>) == sizeof(Queue<std::uint8_t, 16>));
+
+static void registry() {
+    test("registry");
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ < 14
+    // older GCC ignores section attributes on template static members
+    std::print("registry test skipped, needs GCC 14 or clang\n");
+#else
+    bool        rx{};
+    bool        rxSmall{};
+    bool        tx{};
+    std::size_t entries{};
+    forEachQueueStats([&](QueueStatsEntry const& e) {
+        ++entries;
+        if(e.nameView() == "rx" && e.capacity == 7) {
+            rx = true;
+            CHECK(e.stats == &RxStats::stats<7>());
+        }
+        if(e.nameView() == "rx" && e.capacity == 3) {
+            rxSmall = true;
+            CHECK(e.stats == &RxStats::stats<3>());
+        }
+        if(e.nameView() == "tx") {
+            tx = true;
+            CHECK_EQ(e.capacity, 15u);
+        }
+    });
+    CHECK(rx);
+    CHECK(rxSmall);
+    CHECK(tx);
+    CHECK_EQ(entries, 4u);   // rx twice, tx, underflow
+#endif
+}
+
+int main() {
+    counters();
+    rangesAndCommit();
+    perCapacity();
+    underflow();
+    registry();
+
+    if(Kvasir::Test::failures != 0) {
+        std::print("{} checks failed\n", Kvasir::Test::failures);
+        return 1;
+    }
+    return 0;
+}
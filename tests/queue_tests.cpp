@@ -0,0 +1,401 @@
+// Tests for Atomic::Queue: single elements and ranges across the wrap point, for power
+// of two sizes (masked indices) and other sizes, the zero copy reserve/commit and
+// peek/consume API, elements without default constructor or copy and ranges of not
+// trivially copyable elements. spscThreads and popWait run producer and consumer on
+// host threads with OrderingPolicyMultiCore and are meant to stay clean under
+// -DUSE_SANITIZER=thread.
+#include "kvasir_test.hpp"
+
+#include "kvasir/Atomic/Queue.hpp"
+#include "kvasir/Util/attributes.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <print>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Kvasir::Test;
+using Kvasir::Atomic::OrderingPolicyMultiCore;
+using Kvasir::Atomic::OrderingPolicySingleCore;
+using Kvasir::Atomic::OverFlowPolicyIgnore;
+using Kvasir::Atomic::Queue;
+
+template<std::size_t Size>
+static void singleElements() {
+    Queue<std::uint8_t, Size, OverFlowPolicyIgnore> q{};
+    CHECK(q.empty());
+    CHECK_EQ(q.max_size(), Size - 1);
+
+    // several rounds so head and tail wrap
+    std::uint8_t in{};
+    std::uint8_t out{};
+    for(std::size_t round = 0; round != 3 * Size; ++round) {
+        q.push(in++);
+        q.push(in++);
+        CHECK_EQ(q.size(), 2u);
+        std::uint8_t v{};
+        CHECK(q.pop_into(v));
+        CHECK_EQ(v, out++);
+        CHECK_EQ(q.front(), out);
+        q.pop();
+        ++out;
+        CHECK(q.empty());
+    }
+    std::uint8_t v{};
+    CHECK(!q.pop_into(v));
+}
+
+template<std::size_t Size>
+static void rangesAcrossWrap() {
+    Queue<std::uint32_t, Size, OverFlowPolicyIgnore> q{};
+
+    std::uint32_t next{};
+    std::uint32_t expected{};
+    // chunk sizes that do not divide Size, so the copies hit every wrap position
+    for(std::size_t chunk : {std::size_t{3}, Size / 2, Size - 1, std::size_t{1}, Size / 3 + 1}) {
+        for(std::size_t round = 0; round != Size + 1; ++round) {
+            std::vector<std::uint32_t> in(chunk);
+            std::iota(in.begin(), in.end(), next);
+            next += static_cast<std::uint32_t>(chunk);
+            q.push(in);
+            CHECK_EQ(q.size(), chunk);
+
+            std::vector<std::uint32_t> out(chunk);
+            CHECK(q.pop_into(out));
+            bool inOrder = true;
+            for(auto v : out) { inOrder = inOrder && v == expected++; }
+            CHECK(inOrder);
+            CHECK(q.empty());
+        }
+    }
+}
+
+static void rangeLimits() {
+    test("rangeLimits");
+
+    Queue<std::uint8_t, 8, OverFlowPolicyIgnore> q{};
+    std::array<std::uint8_t, 8>                  full{1, 2, 3, 4, 5, 6, 7, 8};
+    q.push(full);   // one more than max_size(), dropped
+    CHECK(q.empty());
+
+    std::array<std::uint8_t, 7> seven{1, 2, 3, 4, 5, 6, 7};
+    q.push(seven);
+    CHECK_EQ(q.size(), 7u);
+
+    std::array<std::uint8_t, 8> tooMany{};
+    CHECK(!q.pop_into(tooMany));
+    CHECK_EQ(q.size(), 7u);
+    CHECK(q.pop_into(seven));
+    CHECK_EQ(seven[6], 7);
+}
+
+static void reserveCommit() {
+    test("reserveCommit");
+
+    Queue<std::uint8_t, 8, OverFlowPolicyIgnore> q{};
+    std::array<std::uint8_t, 5>                  five{};
+    q.push(five);
+    CHECK(q.pop_into(five));   // head and tail at 5
+
+    auto slots = q.reserve(6);
+    CHECK_EQ(slots.size(), 6u);
+    CHECK_EQ(slots.first.size(), 3u);   // 5, 6, 7
+    CHECK_EQ(slots.second.size(), 3u);  // 0, 1, 2
+    CHECK(slots.first.data() == q.data() + 5);
+    CHECK(slots.second.data() == q.data());
+    CHECK(q.empty());   // nothing published before commit
+
+    std::uint8_t v{10};
+    for(auto& s : slots.first) { s = v++; }
+    for(auto& s : slots.second) { s = v++; }
+    q.commit(4);   // only part of the reservation
+    CHECK_EQ(q.size(), 4u);
+
+    // limited by the free space
+    CHECK_EQ(q.reserve(100).size(), 3u);
+    CHECK_EQ(q.reserve().size(), 3u);
+
+    auto elements = q.peek();
+    CHECK_EQ(elements.size(), 4u);
+    CHECK_EQ(elements.first.size(), 3u);
+    CHECK_EQ(elements.second.size(), 1u);
+    CHECK_EQ(elements.first[0], 10);
+    CHECK_EQ(elements.second[0], 13);
+
+    q.consume(3);
+    CHECK_EQ(q.size(), 1u);
+    CHECK_EQ(q.front(), 13);
+    elements = q.peek();
+    CHECK_EQ(elements.first.size(), 1u);
+    CHECK(elements.second.empty());
+    q.consume(1);
+    CHECK(q.empty());
+    CHECK(q.peek().empty());
+}
+
+// move only, no default constructor, counts the live objects
+struct Tracked {
+    static inline int alive{};
+
+    std::unique_ptr<int> value;
+
+    explicit Tracked(int v) : value{std::make_unique<int>(v)} { ++alive; }
+
+    Tracked(Tracked&& other) noexcept : value{std::move(other.value)} { ++alive; }
+
+    Tracked& operator=(Tracked&&) = default;
+
+    ~Tracked() { --alive; }
+};
+
+static void nonTrivialElements() {
+    test("nonTrivialElements");
+
+    {
+        Queue<Tracked, 4, OverFlowPolicyIgnore> q{};
+        CHECK_EQ(Tracked::alive, 0);   // no element constructed up front
+
+        q.emplace(1);
+        q.push(Tracked{2});
+        q.emplace(3);
+        q.emplace(4);   // full, dropped
+        CHECK_EQ(q.size(), 3u);
+        CHECK_EQ(Tracked::alive, 3);
+
+        Tracked out{0};
+        CHECK(q.pop_into(out));
+        CHECK_EQ(*out.value, 1);
+        CHECK_EQ(Tracked::alive, 3);   // out plus two queued
+
+        CHECK_EQ(*q.front().value, 2);
+        q.pop();
+        CHECK_EQ(Tracked::alive, 2);
+
+        // wrap around
+        q.emplace(5);
+        q.emplace(6);
+        CHECK(q.pop_into(out));
+        CHECK_EQ(*out.value, 3);
+        CHECK(q.pop_into(out));
+        CHECK_EQ(*out.value, 5);
+        CHECK_EQ(Tracked::alive, 2);
+
+        q.clear();
+        CHECK(q.empty());
+        CHECK_EQ(Tracked::alive, 1);
+
+        q.emplace(7);
+        q.emplace(8);
+    }
+    // the destructor destroys the remaining elements
+    CHECK_EQ(Tracked::alive, 0);
+}
+
+// copyable but not trivially, counts the live objects
+struct Named {
+    static inline int alive{};
+
+    std::string name;
+
+    explicit Named(std::string n) : name{std::move(n)} { ++alive; }
+
+    Named(Named const& other) : name{other.name} { ++alive; }
+
+    Named& operator=(Named const&) = default;
+    Named& operator=(Named&&)      = default;
+
+    ~Named() { --alive; }
+};
+
+static void nonTrivialRanges() {
+    test("nonTrivialRanges");
+
+    {
+        Queue<Named, 5, OverFlowPolicyIgnore> q{};
+
+        // long names, so the strings live on the heap
+        auto const named = [](int i) { return Named{std::string(32, 'a') + std::to_string(i)}; };
+        int        next{};
+        int        expected{};
+        for(std::size_t chunk : {std::size_t{3}, std::size_t{2}, std::size_t{4}, std::size_t{1}}) {
+            // rounds so the copies start at every slot and wrap
+            for(int round = 0; round != 5; ++round) {
+                std::vector<Named> in;
+                for(std::size_t i = 0; i != chunk; ++i) { in.push_back(named(next++)); }
+                q.push(in);
+                CHECK_EQ(q.size(), chunk);
+                CHECK_EQ(Named::alive, 2 * static_cast<int>(chunk));   // in plus queued copies
+
+                std::vector<Named> out(chunk, Named{""});
+                CHECK(q.pop_into(out));
+                CHECK(q.empty());
+                bool inOrder = true;
+                for(auto const& v : out) { inOrder = inOrder && v.name == named(expected++).name; }
+                CHECK(inOrder);
+                CHECK_EQ(Named::alive, 2 * static_cast<int>(chunk));   // in and out
+            }
+        }
+
+        std::vector<Named> tooMany(5, Named{"x"});
+        q.push(tooMany);   // one more than max_size(), dropped
+        CHECK(q.empty());
+
+        std::vector<Named> two(2, Named{"y"});
+        q.push(two);
+        CHECK(!q.pop_into(tooMany));
+        CHECK_EQ(q.size(), 2u);
+        CHECK_EQ(Named::alive, 5 + 2 + 2);
+    }
+    // the destructor destroys the remaining elements
+    CHECK_EQ(Named::alive, 0);
+}
+
+// not zeroed at startup on the target; on the host only the placement is exercised
+[[KVASIR_NO_INIT]] static Queue<std::uint32_t, 64, OverFlowPolicyIgnore> noInitQueue;
+
+static void noInit() {
+    test("noInit");
+
+    // what a warm reset leaves behind
+    noInitQueue.head_.store(17);
+    noInitQueue.tail_.store(42);
+    noInitQueue.init();
+    CHECK(noInitQueue.empty());
+    noInitQueue.push(5);
+    std::uint32_t v{};
+    CHECK(noInitQueue.pop_into(v));
+    CHECK_EQ(v, 5u);
+}
+
+static_assert(!std::is_trivially_destructible_v<Queue<Tracked, 4>>);
+static_assert(std::is_trivially_destructible_v<Queue<std::uint32_t, 4>>);
+
+// the default mode adds no padding
+static_assert(sizeof(Queue<std::uint8_t, 16, OverFlowPolicyIgnore, OrderingPolicySingleCore>) == 18);
+static_assert(sizeof(Queue<std::uint8_t, 16, OverFlowPolicyIgnore, OrderingPolicyMultiCore>)
+              >= 3 * OrderingPolicyMultiCore::alignment);
+
+static void spscThreads() {
+    test("spscThreads");
+
+    constexpr std::uint32_t count = 200000;
+
+    static Queue<std::uint32_t, 256, OverFlowPolicyIgnore, OrderingPolicyMultiCore> q{};
+
+    std::thread producer{[]() {
+        std::uint32_t                next{};
+        std::array<std::uint32_t, 7> chunk{};
+        while(next != count) {
+            if(next % 3 == 0 && count - next >= chunk.size()) {
+                if(q.reserve(chunk.size()).size() != chunk.size()) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                for(auto& v : chunk) { v = next++; }
+                q.push(chunk);
+            } else if(q.size() < q.max_size()) {
+                q.push(next++);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }};
+
+    std::uint32_t expected{};
+    bool          inOrder = true;
+    while(expected != count) {
+        auto const elements = q.peek();
+        for(auto v : elements.first) { inOrder = inOrder && v == expected++; }
+        for(auto v : elements.second) { inOrder = inOrder && v == expected++; }
+        q.consume(elements.size());
+        if(elements.empty()) { std::this_thread::yield(); }
+    }
+    producer.join();
+
+    CHECK(inOrder);
+    CHECK(q.empty());
+}
+
+static void popWait() {
+    test("popWait");
+
+    constexpr std::uint32_t count = 100000;
+
+    static Queue<std::uint32_t, 64, OverFlowPolicyIgnore, OrderingPolicyMultiCore> q{};
+
+    std::thread producer{[]() {
+        for(std::uint32_t next = 0; next != count;) {
+            if(q.size() == q.max_size()) {
+                std::this_thread::yield();
+                continue;
+            }
+            q.push(next++);
+            // pauses let the consumer run dry and go to sleep
+            if(next % 1024 == 0) { std::this_thread::sleep_for(std::chrono::microseconds{200}); }
+        }
+    }};
+
+    bool inOrder = true;
+    for(std::uint32_t expected = 0; expected != count; ++expected) {
+        std::uint32_t v{};
+        q.pop_wait(v);
+        inOrder = inOrder && v == expected;
+    }
+    producer.join();
+
+    CHECK(inOrder);
+    CHECK(q.empty());
+}
+
+static void popWaitTimeout() {
+    test("popWaitTimeout");
+
+    using Clock = std::chrono::steady_clock;
+
+    Queue<std::uint32_t, 16, OverFlowPolicyIgnore> q{};
+    std::uint32_t                                  v{};
+
+    auto const start = Clock::now();
+    CHECK(!q.pop_wait_for<Clock>(v, std::chrono::milliseconds{5}));
+    CHECK(Clock::now() - start >= std::chrono::milliseconds{5});
+
+    q.push(7);
+    CHECK(q.pop_wait_for<Clock>(v, std::chrono::milliseconds{5}));
+    CHECK_EQ(v, 7u);
+
+    // a deadline in the past still takes an available element
+    q.push(8);
+    CHECK(q.pop_wait_until(v, start));
+    CHECK_EQ(v, 8u);
+    CHECK(!q.pop_wait_until(v, start));
+}
+
+int main() {
+    test("singleElements pow2");
+    singleElements<16>();
+    test("singleElements");
+    singleElements<13>();
+    test("rangesAcrossWrap pow2");
+    rangesAcrossWrap<64>();
+    test("rangesAcrossWrap");
+    rangesAcrossWrap<50>();
+    rangeLimits();
+    reserveCommit();
+    nonTrivialElements();
+    nonTrivialRanges();
+    noInit();
+    spscThreads();
+    popWait();
+    popWaitTimeout();
+
+    if(Kvasir::Test::failures != 0) {
+        std::print("{} checks failed\n", Kvasir::Test::failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,143 @@
+// Tests for KVASIR_PROFILE_SCOPE: per-name statistics, the log2 histogram of the shared
+// ProfileStats engine and the link-time registry, driven by a virtual clock.
+#define KVASIR_ENABLE_PROFILE_SCOPES
+#define KVASIR_PROFILE_TIME_SOURCE ScopeClock
+
+#include "kvasir_test.hpp"
+
+#include <cstdint>
+#include <print>
+#include <string_view>
+
+struct ScopeClock {
+    static inline std::uint32_t time{};
+
+    static std::uint32_t now() noexcept { return time; }
+};
+
+#include "kvasir/StartUp/ScopeProfiler.hpp"
+
+using namespace Kvasir::Test;
+using namespace Kvasir::Startup;
+
+static void filterUpdate(std::uint32_t cycles) {
+    KVASIR_PROFILE_SCOPE("filter");
+    ScopeClock::time += cycles;
+}
+
+static void parse(std::uint32_t cycles) {
+    KVASIR_PROFILE_SCOPE("parser");
+    ScopeClock::time += cycles;
+    {
+        KVASIR_PROFILE_SCOPE("parser.crc");
+        ScopeClock::time += 1;
+    }
+}
+
+// a second site with the same name shares the statistics
+static void parseShort() {
+    KVASIR_PROFILE_SCOPE("parser");
+    ScopeClock::time += 3;
+}
+
+using FilterSite = ScopeProfileSite<"filter", ScopeClock>;
+using ParserSite = ScopeProfileSite<"parser", ScopeClock>;
+using CrcSite    = ScopeProfileSite<"parser.crc", ScopeClock>;
+
+static void scopeDurations() {
+    test("scopeDurations");
+
+    filterUpdate(10);
+    filterUpdate(30);
+    filterUpdate(20);
+
+    auto const& s = FilterSite::stats;
+    CHECK_EQ(s.count.load(), 3u);
+    CHECK_EQ(s.minimum(), 10u);
+    CHECK_EQ(s.maximum(), 30u);
+    CHECK_EQ(s.average(), 20u);
+}
+
+static void nestedAndSharedScopes() {
+    test("nestedAndSharedScopes");
+
+    parse(100);
+    parseShort();
+
+    // outer scope includes the nested one
+    CHECK_EQ(ParserSite::stats.count.load(), 2u);
+    CHECK_EQ(ParserSite::stats.maximum(), 101u);
+    CHECK_EQ(ParserSite::stats.minimum(), 3u);
+    CHECK_EQ(CrcSite::stats.count.load(), 1u);
+    CHECK_EQ(CrcSite::stats.maximum(), 1u);
+}
+
+static void histogram() {
+    test("histogram");
+
+    ProfileStats<true> s{};
+    s.record(0);
+    s.record(1);
+    s.record(2);
+    s.record(3);
+    s.record(1000);     // bit width 10
+    s.record(1023);
+    s.record(1024);     // bit width 11
+    s.record(0xFFFFFFFF);
+
+    CHECK_EQ(s.histogram[0].load(), 1u);
+    CHECK_EQ(s.histogram[1].load(), 1u);
+    CHECK_EQ(s.histogram[2].load(), 2u);
+    CHECK_EQ(s.histogram[10].load(), 2u);
+    CHECK_EQ(s.histogram[11].load(), 1u);
+    CHECK_EQ(s.histogram[32].load(), 1u);
+    CHECK_EQ(s.count.load(), 8u);
+
+    std::uint32_t sum{};
+    for(auto const& b : s.histogram) { sum += b.load(); }
+    CHECK_EQ(sum, 8u);
+}
+
+static void registry() {
+    test("registry");
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ < 14
+    // older GCC ignores section attributes on template static members
+    std::print("registry test skipped, needs GCC 14 or clang\n");
+#else
+    bool        filter{};
+    bool        parser{};
+    bool        crc{};
+    std::size_t entries{};
+    forEachScopeProfile([&](ScopeProfileEntry const& e) {
+        ++entries;
+        if(e.nameView() == "filter") {
+            filter = true;
+            CHECK(e.stats == &FilterSite::stats);
+        }
+        if(e.nameView() == "parser") {
+            CHECK(!parser);   // one entry per name, not per site
+            parser = true;
+            CHECK(e.stats == &ParserSite::stats);
+        }
+        if(e.nameView() == "parser.crc") { crc = true; }
+    });
+    CHECK(filter);
+    CHECK(parser);
+    CHECK(crc);
+    CHECK_EQ(entries, 3u);
+#endif
+}
+
+int main() {
+    scopeDurations();
+    nestedAndSharedScopes();
+    histogram();
+    registry();
+
+    if(Kvasir::Test::failures != 0) {
+        std::print("{} checks failed\n", Kvasir::Test::failures);
+        return 1;
+    }
+    return 0;
+}
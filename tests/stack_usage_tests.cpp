@@ -0,0 +1,54 @@
+// Tests for the stack painting helpers behind Kvasir::stackHighWater(): painting a
+// region and finding the deepest overwritten word from the bottom.
+#include "kvasir_test.hpp"
+
+#include "kvasir/Util/StackUsage.hpp"
+
+#include <array>
+#include <cstdint>
+#include <print>
+
+using namespace Kvasir::Test;
+
+static void untouchedStack() {
+    test("untouchedStack");
+
+    std::array<std::uint32_t, 37> stack{};
+    Kvasir::Detail::paint(stack.data(), stack.data() + stack.size());
+    for(auto w : stack) { CHECK_EQ(w, Kvasir::stackPaintPattern); }
+    CHECK_EQ(Kvasir::Detail::paintedWords(stack.data(), stack.data() + stack.size()), 37u);
+}
+
+// the stack grows down: everything above the deepest overwritten word counts as used,
+// even words that happen to hold the pattern again
+static void deepestWriteCounts() {
+    test("deepestWriteCounts");
+
+    for(std::size_t depth = 0; depth != 37; ++depth) {
+        std::array<std::uint32_t, 37> stack{};
+        Kvasir::Detail::paint(stack.data(), stack.data() + stack.size());
+        stack[depth]     = 0;
+        stack.back()     = 1;
+        auto const words = Kvasir::Detail::paintedWords(stack.data(), stack.data() + stack.size());
+        CHECK_EQ(words, depth);
+    }
+}
+
+static void emptyRegion() {
+    test("emptyRegion");
+
+    std::array<std::uint32_t, 1> stack{};
+    CHECK_EQ(Kvasir::Detail::paintedWords(stack.data(), stack.data()), 0u);
+}
+
+int main() {
+    untouchedStack();
+    deepestWriteCounts();
+    emptyRegion();
+
+    if(Kvasir::Test::failures != 0) {
+        std::print("{} checks failed\n", Kvasir::Test::failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,197 @@
+// Tests for the counter extension of the SysTick and timer based profiling time sources,
+// driven by simulated counters.
+#include "kvasir_test.hpp"
+
+#include "kvasir/StartUp/IsrProfiler.hpp"
+
+#include <cstdint>
+#include <print>
+
+using namespace Kvasir::Test;
+using Kvasir::Startup::TimerTimeSource;
+namespace Detail = Kvasir::Startup::Detail;
+
+// free-running up-counter of Bits bits, advanced by the test
+template<unsigned Bits>
+struct SimTimer {
+    static constexpr unsigned bits = Bits;
+    static inline std::uint64_t ticks{};
+    static inline bool          enabled{};
+
+    static std::uint32_t count() noexcept {
+        if constexpr(Bits == 32) {
+            return static_cast<std::uint32_t>(ticks);
+        } else {
+            return static_cast<std::uint32_t>(ticks & ((std::uint64_t{1} << Bits) - 1));
+        }
+    }
+
+    static void enable() noexcept { enabled = true; }
+};
+
+struct TimerWithoutEnable {
+    static constexpr unsigned bits = 32;
+
+    static std::uint32_t count() noexcept { return 42; }
+};
+
+static void downCounterCycles() {
+    test("downCounterCycles");
+
+    constexpr std::uint32_t reload = 0x00FFFFFF;
+
+    // counter starts at reload and counts down
+    CHECK_EQ(Detail::downCounterCycles(0, reload, reload, false), 0u);
+    CHECK_EQ(Detail::downCounterCycles(0, reload, reload - 10, false), 10u);
+    CHECK_EQ(Detail::downCounterCycles(0, reload, 0, false), reload);
+    CHECK_EQ(Detail::downCounterCycles(1, reload, reload, false), reload + 1);
+    CHECK_EQ(Detail::downCounterCycles(3, reload, reload - 5, false), 3 * (reload + 1) + 5);
+
+    // wrapped but the reload ISR did not run yet
+    CHECK_EQ(Detail::downCounterCycles(0, reload, reload - 2, true), reload + 1 + 2);
+    CHECK_EQ(Detail::downCounterCycles(0, reload, reload - 2, true),
+             Detail::downCounterCycles(1, reload, reload - 2, false));
+}
+
+// SysTick sets PENDSTSET on the 1 -> 0 step and reloads on the next clock, the reads
+// around it must never go backwards
+static void downCounterCyclesMonotonic() {
+    test("downCounterCyclesMonotonic");
+
+    constexpr std::uint32_t reload = 0x00FFFFFF;
+
+    struct Read {
+        std::uint32_t reloads;
+        std::uint32_t current;
+        bool          pending;
+    };
+
+    for(std::uint32_t r : {0u, 255u}) {
+        Read const reads[]{
+          {    r,          2, false},
+          {    r,          1, false},
+          {    r,          0,  true}, // pended, not reloaded yet
+          {    r,     reload,  true}, // reloaded, ISR still pending
+          {    r, reload - 1,  true},
+          {r + 1, reload - 2, false}, // ISR ran
+          {r + 1, reload - 3, false},
+        };
+        std::uint32_t previous
+          = Detail::downCounterCycles(reads[0].reloads, reload, reads[0].current, reads[0].pending);
+        for(auto const& read : reads) {
+            std::uint32_t const now
+              = Detail::downCounterCycles(read.reloads, reload, read.current, read.pending);
+            // difference instead of <, the 255 case wraps at 2^32
+            CHECK(now - previous <= 1u);
+            previous = now;
+        }
+    }
+}
+
+// 2^24 periods make the 32 bit result wrap exactly like a 32 bit cycle counter
+static void downCounterCyclesWrap32() {
+    test("downCounterCyclesWrap32");
+
+    constexpr std::uint32_t reload = 0x00FFFFFF;
+
+    CHECK_EQ(Detail::downCounterCycles(255, reload, 0, false), 0xFFFFFFFFu);
+    CHECK_EQ(Detail::downCounterCycles(256, reload, reload, false), 0u);
+    // pending with the counter still at 0 is the end of the 256th period
+    CHECK_EQ(Detail::downCounterCycles(255, reload, 0, true), 0xFFFFFFFFu);
+    CHECK_EQ(Detail::downCounterCycles(256, reload, reload - 7, false)
+               - Detail::downCounterCycles(255, reload, 3, false),
+             3u + 7u + 1u);
+}
+
+static void extendCounter() {
+    test("extendCounter");
+
+    // no wrap
+    CHECK_EQ(Detail::extendCounter<16>(0, 100), 100u);
+    CHECK_EQ(Detail::extendCounter<16>(100, 200), 200u);
+    // raw counter wrapped from 0xFFF0 to 0x0010
+    CHECK_EQ(Detail::extendCounter<16>(0xFFF0, 0x0010), 0x10010u);
+    // extended value keeps growing past 2^16
+    CHECK_EQ(Detail::extendCounter<16>(0x3FFF0, 0x0005), 0x40005u);
+    // extended value wraps at 2^32
+    CHECK_EQ(Detail::extendCounter<16>(0xFFFFFFF0, 0x0002), 0x2u);
+    // full width counters pass through
+    CHECK_EQ(Detail::extendCounter<32>(0x1234, 0x5), 0x5u);
+    // 24 bit
+    CHECK_EQ(Detail::extendCounter<24>(0x00FFFFFE, 0x000001), 0x01000001u);
+}
+
+static void timerTimeSourceExtends() {
+    test("timerTimeSourceExtends");
+
+    using Timer = SimTimer<16>;
+    using TS    = TimerTimeSource<Timer>;
+
+    TS::enable();
+    CHECK(Timer::enabled);
+
+    Timer::ticks = 0;
+    CHECK_EQ(TS::now(), 0u);
+
+    // step just below one period at a time, the extended time must track ticks
+    std::uint32_t previous = TS::now();
+    for(int i = 0; i != 100; ++i) {
+        Timer::ticks += 0xFFFF;
+        std::uint32_t const now = TS::now();
+        CHECK_EQ(now, static_cast<std::uint32_t>(Timer::ticks));
+        CHECK_EQ(now - previous, 0xFFFFu);
+        previous = now;
+    }
+}
+
+static void timerTimeSourceWraps32() {
+    test("timerTimeSourceWraps32");
+
+    using Timer = SimTimer<24>;
+    using TS    = TimerTimeSource<Timer>;
+
+    Timer::ticks = 0;
+    TS::now();
+
+    // drive the extended counter across 2^32, durations stay correct
+    std::uint32_t previous = TS::now();
+    while(Timer::ticks < (std::uint64_t{1} << 32) + 0x2000000) {
+        Timer::ticks += 0x00F00000;
+        std::uint32_t const now = TS::now();
+        CHECK_EQ(now - previous, 0x00F00000u);
+        CHECK_EQ(now, static_cast<std::uint32_t>(Timer::ticks));
+        previous = now;
+    }
+}
+
+static void timerTimeSourceFullWidth() {
+    test("timerTimeSourceFullWidth");
+
+    using Timer = SimTimer<32>;
+    using TS    = TimerTimeSource<Timer>;
+
+    Timer::ticks = 0xFFFFFFF0;
+    CHECK_EQ(TS::now(), 0xFFFFFFF0u);
+    Timer::ticks += 0x20;
+    CHECK_EQ(TS::now(), 0x10u);
+
+    // enable is optional
+    TimerTimeSource<TimerWithoutEnable>::enable();
+    CHECK_EQ(TimerTimeSource<TimerWithoutEnable>::now(), 42u);
+}
+
+int main() {
+    downCounterCycles();
+    downCounterCyclesMonotonic();
+    downCounterCyclesWrap32();
+    extendCounter();
+    timerTimeSourceExtends();
+    timerTimeSourceWraps32();
+    timerTimeSourceFullWidth();
+
+    if(Kvasir::Test::failures != 0) {
+        std::print("{} checks failed\n", Kvasir::Test::failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+// Benchmark of Atomic::TripleBuffer against the guarded copy it replaces (a copy of
+// the whole value in and out under a lock, std::mutex standing in for the global
+// InterruptGuard): ns per write plus read of the latest value, in one thread and with
+// writer and reader on separate threads. On the target the guarded copy also blocks
+// every interrupt for the duration of the copy, the triple buffer blocks none. Not run
+// by ctest, build and run kvasir_benchmark_triple_buffer manually (in a Release build).
+#include "kvasir/Atomic/TripleBuffer.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <print>
+#include <thread>
+
+using Kvasir::Atomic::OrderingPolicyMultiCore;
+using Kvasir::Atomic::TripleBuffer;
+
+template<typename T>
+struct GuardedValue {
+    std::mutex m;
+    T          value{};
+
+    void write(T const& v) {
+        std::lock_guard l{m};
+        value = v;
+    }
+
+    T read() {
+        std::lock_guard l{m};
+        return value;
+    }
+};
+
+template<std::size_t Words>
+struct Measurement {
+    std::array<std::uint32_t, Words> words;
+};
+
+template<typename T>
+static T readValue(GuardedValue<T>& g) {
+    return g.read();
+}
+
+template<typename T>
+static T const& readValue(TripleBuffer<T, OrderingPolicyMultiCore>& b) {
+    return b.read();
+}
+
+template<std::size_t Words,
+         typename B>
+static double nsPerUpdate(B& b) {
+    constexpr std::uint32_t rounds = 5'000'000;
+    Measurement<Words>      m{};
+    std::uint64_t           check{};
+
+    auto const start = std::chrono::steady_clock::now();
+    for(std::uint32_t i = 0; i != rounds; ++i) {
+        m.words[0] = i;
+        b.write(m);
+        check += readValue(b).words[0];
+    }
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    [[maybe_unused]] auto volatile keep = check;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / rounds;
+}
+
+// writer thread updating as fast as it can, the reader thread reads and reports the
+// reads per us it achieves meanwhile
+template<std::size_t Words,
+         typename B>
+static double readsPerUs(B& b) {
+    std::atomic<bool> done{};
+    std::thread       writer{[&]() {
+        Measurement<Words> m{};
+        for(std::uint32_t i = 0; i != 2'000'000; ++i) {
+            m.words[0] = i;
+            b.write(m);
+        }
+        done = true;
+    }};
+    std::uint64_t reads{};
+    std::uint64_t check{};
+    auto const    start = std::chrono::steady_clock::now();
+    while(!done.load(std::memory_order_relaxed)) {
+        check += readValue(b).words[0];
+        ++reads;
+    }
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    writer.join();
+    [[maybe_unused]] auto volatile keep = check;
+    return static_cast<double>(reads) / std::chrono::duration<double, std::micro>(elapsed).count();
+}
+
+template<std::size_t Words>
+static void bench() {
+    static GuardedValue<Measurement<Words>>                          guarded{};
+    static TripleBuffer<Measurement<Words>, OrderingPolicyMultiCore> triple{};
+    std::print("  {:3} words: write+read {:6.1f} -> {:6.1f} ns, reads under load {:7.2f} -> {:7.2f} /us\n",
+               Words,
+               nsPerUpdate<Words>(guarded),
+               nsPerUpdate<Words>(triple),
+               readsPerUs<Words>(guarded),
+               readsPerUs<Words>(triple));
+}
+
+int main() {
+    std::print("latest value sharing, guarded copy -> TripleBuffer (OrderingPolicyMultiCore)\n");
+    bench<4>();
+    bench<16>();
+    bench<64>();
+    return 0;
+}
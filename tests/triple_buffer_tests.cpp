@@ -0,0 +1,124 @@
+// Tests for Atomic::TripleBuffer: latest value semantics single threaded, and a
+// writer and a reader on host threads (OrderingPolicyMultiCore) checking for torn
+// snapshots; meant to stay clean under -DUSE_SANITIZER=thread.
+#include "kvasir_test.hpp"
+
+#include "kvasir/Atomic/TripleBuffer.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <print>
+#include <thread>
+
+using namespace Kvasir::Test;
+using Kvasir::Atomic::OrderingPolicyMultiCore;
+using Kvasir::Atomic::OrderingPolicySingleCore;
+using Kvasir::Atomic::TripleBuffer;
+
+static void latestValue() {
+    test("latestValue");
+
+    TripleBuffer<std::uint32_t> b{};
+    CHECK(!b.fresh());
+    CHECK(!b.update());
+    CHECK_EQ(b.front(), 0u);
+
+    b.write(1);
+    CHECK(b.fresh());
+    CHECK_EQ(b.front(), 0u);   // not picked up yet
+    CHECK(b.update());
+    CHECK_EQ(b.front(), 1u);
+    CHECK(!b.update());
+    CHECK_EQ(b.front(), 1u);
+
+    // only the newest of several writes is seen
+    b.write(2);
+    b.write(3);
+    b.write(4);
+    CHECK_EQ(b.read(), 4u);
+    CHECK(!b.fresh());
+
+    // filled in place
+    b.back() = 5;
+    CHECK(!b.fresh());
+    b.publish();
+    CHECK_EQ(b.read(), 5u);
+
+    // the three buffers stay distinct through all swaps
+    for(std::uint32_t i = 0; i != 10; ++i) {
+        b.write(i);
+        if(i % 3 == 0) { CHECK_EQ(b.read(), i); }
+        CHECK(b.writer_ != b.reader_);
+        CHECK(b.writer_ != (b.state_.load() & b.indexMask));
+        CHECK(b.reader_ != (b.state_.load() & b.indexMask));
+    }
+}
+
+// the default mode adds no padding
+static_assert(sizeof(TripleBuffer<std::uint32_t, OrderingPolicySingleCore>) == 3 * 4 + 3 + 1);
+static_assert(sizeof(TripleBuffer<std::uint32_t, OrderingPolicyMultiCore>)
+              >= 6 * OrderingPolicyMultiCore::alignment);
+
+// every word of a snapshot is the same, a torn one has differing words
+struct Measurement {
+    std::array<std::uint32_t, 16> words;
+};
+
+static void noTornSnapshots() {
+    test("noTornSnapshots");
+
+    constexpr std::uint32_t writes = 200000;
+
+    static TripleBuffer<Measurement, OrderingPolicyMultiCore> b{};
+    std::atomic<bool>                                         done{};
+
+    std::thread writer{[&]() {
+        for(std::uint32_t i = 1; i <= writes; ++i) {
+            auto& m = b.back();
+            for(auto& w : m.words) {
+                w = i;
+                // lets the reader run in the middle of the write even on one CPU
+                if(i % 64 == 0 && &w == &m.words[8]) { std::this_thread::yield(); }
+            }
+            b.publish();
+        }
+        done = true;
+    }};
+
+    std::uint32_t torn{};
+    std::uint32_t updates{};
+    std::uint32_t last{};
+    while(true) {
+        bool const finished = done.load();
+        if(b.update()) {
+            ++updates;
+            auto const& m = b.front();
+            for(auto const& w : m.words) {
+                if(&w == &m.words[8]) { std::this_thread::yield(); }
+                if(w != m.words[0]) { ++torn; }
+            }
+            if(m.words[0] <= last) { ++torn; }   // values only move forward
+            last = m.words[0];
+        } else {
+            std::this_thread::yield();
+        }
+        if(finished && !b.fresh()) { break; }
+    }
+    writer.join();
+
+    CHECK_EQ(torn, 0u);
+    CHECK(updates != 0);
+    CHECK_EQ(last, writes);   // the final value is never lost
+}
+
+int main() {
+    latestValue();
+    noTornSnapshots();
+
+    if(Kvasir::Test::failures != 0) {
+        std::print("{} checks failed\n", Kvasir::Test::failures);
+        return 1;
+    }
+    return 0;
+}